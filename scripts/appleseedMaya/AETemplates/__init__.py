@@ -137,10 +137,28 @@ class AEappleseedNodeTemplate(pm.ui.AETemplate):
             self.addControl('asExportUVs', label='Export UVs')
             self.addControl('asExportNormals', label='Export Normals')
             self.addControl('asSmoothTangents', label='Smooth Tangents')
+            self.addSeparator()
+            self.addControl('asStandIn', label='Export As Stand-In')
+            self.endLayout()
+
+            self.beginLayout('Motion Blur', collapse=1)
+            self.addControl('asMotionBlurSamplesMode', label='Samples')
+            self.addControl('asTransformMotionSamples', label='Transform Samples')
+            self.addControl('asDeformMotionSamples', label='Deformation Samples')
+            self.addControl('asMotionBlurTolerance', label='Adaptive Tolerance')
             self.endLayout()
 
             self.endLayout()
 
+        elif self.thisNode.type() == 'xgmDescription':
+            self.beginLayout('appleseed', collapse=1)
+            self.addControl('asLodEnable', label='Enable Density Falloff')
+            self.addControl('asDensityFalloffStart', label='Falloff Start')
+            self.addControl('asDensityFalloffEnd', label='Falloff End')
+            self.addControl('asMinDensity', label='Min Density')
+            self.addControl('asWidthCompensation', label='Width Compensation')
+            self.endLayout()
+
         elif self.thisNode.type() == 'shadingEngine':
             self.beginLayout('appleseed', collapse=1)
             self.addControl('asDoubleSided', label='Double Sided')
@@ -1532,6 +1532,13 @@ class AppleseedRenderGlobalsSystemTab(AppleseedRenderGlobalsTab):
         if path:
             mc.setAttr("appleseedRenderGlobals.logFilename", path, type="string")
 
+    def __chooseProfileFilename(self):
+        logger.debug("Choose profile filename called!")
+        path = pm.fileDialog2(filemode=0, fileFilter="Trace files (*.json)")
+
+        if path:
+            mc.setAttr("appleseedRenderGlobals.profileFilename", path[0], type="string")
+
     def create(self):
         # Create default render globals node if needed
         createGlobalNodes()
@@ -1583,6 +1590,29 @@ class AppleseedRenderGlobalsSystemTab(AppleseedRenderGlobalsTab):
 
                         pm.separator(height=2)
 
+                with pm.frameLayout("profilingFrameLayout", label="Profiling", collapsable=True, collapse=True):
+                    with pm.columnLayout("profilingColumnLayout", adjustableColumn=True, width=g_columnWidth):
+
+                        pm.separator(height=2)
+
+                        self._addControl(
+                            ui=pm.checkBoxGrp(
+                                label="Profile Export",
+                                columnAttach=(1, "right", 4),
+                                height=24),
+                            attrName="profileExport")
+
+                        self._addControl(
+                            ui=pm.textFieldButtonGrp(
+                                label="Trace Filename",
+                                buttonLabel="...",
+                                height=22,
+                                columnAttach=(1, "right", 4),
+                                buttonCommand=self.__chooseProfileFilename),
+                            attrName="profileFilename")
+
+                        pm.separator(height=2)
+
                 with pm.frameLayout("systemFrameLayout", label="System", collapsable=True, collapse=False):
                     with pm.columnLayout("systemColumnLayout", adjustableColumn=True, width=g_columnWidth):
 
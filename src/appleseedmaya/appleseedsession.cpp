@@ -32,6 +32,7 @@
 // appleseed-maya headers.
 #include "appleseedmaya/attributeutils.h"
 #include "appleseedmaya/exceptions.h"
+#include "appleseedmaya/exportprofiler.h"
 #include "appleseedmaya/exporters/alphamapexporter.h"
 #include "appleseedmaya/exporters/dagnodeexporter.h"
 #include "appleseedmaya/exporters/exporterfactory.h"
@@ -39,12 +40,17 @@
 #include "appleseedmaya/exporters/shadingengineexporter.h"
 #include "appleseedmaya/exporters/shadingnetworkexporter.h"
 #include "appleseedmaya/exporters/shapeexporter.h"
+#include "appleseedmaya/hashing.h"
 #include "appleseedmaya/idlejobqueue.h"
 #include "appleseedmaya/logger.h"
+#include "appleseedmaya/memoryreport.h"
+#include "appleseedmaya/nodemap.h"
 #include "appleseedmaya/pythonbridge.h"
 #include "appleseedmaya/renderercontroller.h"
 #include "appleseedmaya/renderglobalsnode.h"
 #include "appleseedmaya/renderviewtilecallback.h"
+#include "appleseedmaya/shadergrouphasher.h"
+#include "appleseedmaya/textureprefetcher.h"
 
 // Build options header.
 #include "foundation/core/buildoptions.h"
@@ -75,6 +81,10 @@
 #include <maya/MAnimControl.h>
 #include <maya/MCommonRenderSettingsData.h>
 #include <maya/MDagPath.h>
+#if MAYA_API_VERSION >= 201800
+#include <maya/MDGContext.h>
+#include <maya/MDGContextGuard.h>
+#endif
 #include <maya/MFnDagNode.h>
 #include <maya/MFnDependencyNode.h>
 #include <maya/MFnRenderLayer.h>
@@ -94,8 +104,12 @@
 // Standard headers.
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <fstream>
+#include <map>
 #include <memory>
+#include <set>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -205,6 +219,10 @@ namespace
     asf::LogMessage::Category       g_savedLogLevel;          // Saved log level.
     std::unique_ptr<SessionImpl>    g_globalSession;          // Global session.
 
+    // Number of heaviest nodes listed in the memory reports.
+    const size_t MaxMemoryReportNodesInLog = 10;
+    const size_t MaxMemoryReportNodesInFile = 100;
+
     // RAII class to end active the session in an exception safe way.
     struct ScopedEndSession
     {
@@ -229,9 +247,8 @@ namespace
 
             ShadingEngineExporterPtr createShadingEngineExporter(const MObject& object) const override
             {
-                MFnDependencyNode depNodeFn(object);
-
-                auto it = m_self.m_shadingEngineExporters.find(depNodeFn.name());
+                const NodeKey key(object);
+                auto it = m_self.m_shadingEngineExporters.find(key);
 
                 if (it != m_self.m_shadingEngineExporters.end())
                     return it->second;
@@ -241,7 +258,7 @@ namespace
                         object,
                         *m_self.mainAssembly(),
                         m_self.m_sessionMode));
-                m_self.m_shadingEngineExporters[depNodeFn.name()] = exporter;
+                m_self.m_shadingEngineExporters.set(key, exporter);
                 return exporter;
             }
 
@@ -250,9 +267,8 @@ namespace
                 const MObject&                object,
                 const MPlug&                  outputPlug) const override
             {
-                MFnDependencyNode depNodeFn(object);
-
-                auto it = m_self.m_shadingNetworkExporters[context].find(depNodeFn.name());
+                const NodeKey key(object);
+                auto it = m_self.m_shadingNetworkExporters[context].find(key);
 
                 if (it != m_self.m_shadingNetworkExporters[context].end())
                     return it->second;
@@ -264,16 +280,15 @@ namespace
                         outputPlug,
                         *m_self.mainAssembly(),
                         m_self.m_sessionMode));
-                m_self.m_shadingNetworkExporters[context][depNodeFn.name()] = exporter;
+                m_self.m_shadingNetworkExporters[context].set(key, exporter);
                 return exporter;
             }
 
             AlphaMapExporterPtr createAlphaMapExporter(
                 const MObject&                  object) const override
             {
-                MFnDependencyNode depNodeFn(object);
-
-                auto it = m_self.m_alphaMapExporters.find(depNodeFn.name());
+                const NodeKey key(object);
+                auto it = m_self.m_alphaMapExporters.find(key);
 
                 if (it != m_self.m_alphaMapExporters.end())
                     return it->second;
@@ -285,7 +300,7 @@ namespace
                         m_self.m_sessionMode));
 
                 if (exporter)
-                    m_self.m_alphaMapExporters[depNodeFn.name()] = exporter;
+                    m_self.m_alphaMapExporters.set(key, exporter);
 
                 return exporter;
             }
@@ -341,6 +356,51 @@ namespace
         {
             PythonBridge::clearCurrentProject();
             abortRender();
+            m_texturePrefetcher.stop();
+            finishProfiling();
+            removeTemporaryDirectory();
+        }
+
+        const bfs::path& temporaryDirectory()
+        {
+            if (m_temporaryDirectory.empty())
+            {
+                boost::system::error_code ec;
+                bfs::path dir = bfs::temp_directory_path(ec);
+
+                if (!ec)
+                    dir = bfs::unique_path(dir / "appleseedmaya-%%%%-%%%%-%%%%", ec);
+
+                if (!ec && bfs::create_directories(dir, ec))
+                    m_temporaryDirectory = dir;
+                else
+                {
+                    RENDERER_LOG_WARNING(
+                        "Could not create temporary directory %s.",
+                        dir.string().c_str());
+                }
+            }
+
+            return m_temporaryDirectory;
+        }
+
+        void removeTemporaryDirectory()
+        {
+            if (m_temporaryDirectory.empty())
+                return;
+
+            boost::system::error_code ec;
+            bfs::remove_all(m_temporaryDirectory, ec);
+
+            if (ec)
+            {
+                RENDERER_LOG_WARNING(
+                    "Could not remove temporary directory %s, error = %s.",
+                    m_temporaryDirectory.string().c_str(),
+                    ec.message().c_str());
+            }
+
+            m_temporaryDirectory.clear();
         }
 
         void initializeConfiguration(asr::ParamArray& params) const
@@ -416,6 +476,9 @@ namespace
             exportDefaultRenderGlobals();
             MObject globalsNode = exportAppleseedRenderGlobals();
 
+            startProfiling(globalsNode);
+            ScopedProfileEvent profileEvent(m_profiler, "exportProject");
+
             AppleseedSession::MotionBlurSampleTimes motionBlurSampleTimes;
 
             // Only do motion blur for non progressive renders.
@@ -426,6 +489,10 @@ namespace
 
             exportScene(motionBlurSampleTimes);
 
+            // Renders collect it once rendering started, to not delay the first pixels.
+            if (m_sessionMode == AppleseedSession::ExportSession)
+                collectMemoryUsage();
+
             // Set the shutter open and close times in all cameras.
             asr::CameraContainer& cameras = m_project->get_scene()->cameras();
 
@@ -560,37 +627,87 @@ namespace
 
         void exportScene(const AppleseedSession::MotionBlurSampleTimes& motionBlurSampleTimes)
         {
-            createExporters();
-            throwIfUserAborted();
+            // The animation analysis is shared by the exporters during this export.
+            DagNodeExporter::clearAnimationCache();
 
-            RENDERER_LOG_DEBUG("Creating alpha map entities");
-            for (auto it = m_alphaMapExporters.begin(), e = m_alphaMapExporters.end(); it != e; ++it)
-                it->second->createEntities();
+            {
+                ScopedProfileEvent profileEvent(m_profiler, "createExporters");
+                createExporters();
+            }
 
             throwIfUserAborted();
 
-            RENDERER_LOG_DEBUG("Creating shading network entities");
-            for (size_t i = 0; i < NumShadingNetworkContexts; ++i)
+            std::set<float> allTimes = motionBlurSampleTimes.m_allTimes;
+
             {
-                for (auto it = m_shadingNetworkExporters[i].begin(), e = m_shadingNetworkExporters[i].end(); it != e; ++it)
+                ScopedProfileEvent profileEvent(m_profiler, "createEntities");
+
+                RENDERER_LOG_DEBUG("Creating alpha map entities");
+                for (auto it = m_alphaMapExporters.begin(), e = m_alphaMapExporters.end(); it != e; ++it)
+                {
+                    ScopedProfileEvent nodeEvent(m_profiler, "createEntities", it->first);
                     it->second->createEntities();
-            }
+                }
 
-            RENDERER_LOG_DEBUG("Creating shading engine entities");
-            for (auto it = m_shadingEngineExporters.begin(), e = m_shadingEngineExporters.end(); it != e; ++it)
-                it->second->createEntities(m_options);
+                throwIfUserAborted();
 
-            throwIfUserAborted();
+                RENDERER_LOG_DEBUG("Creating shading network entities");
+                for (size_t i = 0; i < NumShadingNetworkContexts; ++i)
+                {
+                    for (auto it = m_shadingNetworkExporters[i].begin(), e = m_shadingNetworkExporters[i].end(); it != e; ++it)
+                    {
+                        ScopedProfileEvent nodeEvent(m_profiler, "createEntities", it->first);
+                        it->second->createEntities();
+                    }
+                }
 
-            RENDERER_LOG_DEBUG("Creating dag entities");
-            for (auto it = m_dagExporters.begin(), e = m_dagExporters.end(); it != e; ++it)
-                it->second->createEntities(m_options, motionBlurSampleTimes);
+                // Textures are known now, start reading them while the rest is exported.
+                if (m_sessionMode != AppleseedSession::ExportSession)
+                    prefetchTextures();
+
+                RENDERER_LOG_DEBUG("Creating shading engine entities");
+                for (auto it = m_shadingEngineExporters.begin(), e = m_shadingEngineExporters.end(); it != e; ++it)
+                {
+                    ScopedProfileEvent nodeEvent(m_profiler, "createEntities", it->first);
+                    it->second->createEntities(m_options);
+                }
+
+                throwIfUserAborted();
+
+                RENDERER_LOG_DEBUG("Collecting motion blur sample times");
+                for (auto it = m_dagExporters.begin(), e = m_dagExporters.end(); it != e; ++it)
+                {
+                    it->second->initializeMotionBlurSampleTimes(motionBlurSampleTimes);
+
+                    const AppleseedSession::MotionBlurSampleTimes& objectTimes = it->second->motionBlurSampleTimes();
+                    allTimes.insert(objectTimes.m_allTimes.begin(), objectTimes.m_allTimes.end());
+                }
+
+                throwIfUserAborted();
+
+                RENDERER_LOG_DEBUG("Creating dag entities");
+                for (auto it = m_dagExporters.begin(), e = m_dagExporters.end(); it != e; ++it)
+                {
+                    ScopedProfileEvent nodeEvent(m_profiler, "createEntities", it->first);
+                    it->second->createEntities(m_options, it->second->motionBlurSampleTimes());
+                }
+            }
 
             RENDERER_LOG_DEBUG("Exporting motion steps");
-            auto frameIt(motionBlurSampleTimes.m_allTimes.begin());
-            auto frameEnd(motionBlurSampleTimes.m_allTimes.end());
+            auto frameIt(allTimes.begin());
+            auto frameEnd(allTimes.end());
             for (; frameIt != frameEnd; ++frameIt)
             {
+                ScopedProfileEvent profileEvent(m_profiler, "exportMotionStep");
+
+#if MAYA_API_VERSION >= 201800
+                // Evaluate the motion step in a time context. Unlike changing
+                // the current time, this only evaluates the plugs read by the
+                // exporters and does not refresh the UI.
+                RENDERER_LOG_DEBUG("Evaluating frame %f", *frameIt);
+                MDGContext context(MTime(*frameIt, MTime::uiUnit()));
+                MDGContextGuard contextGuard(context);
+#else
                 const float now = static_cast<float>(MAnimControl::currentTime().value());
 
                 if (*frameIt != now)
@@ -598,6 +715,7 @@ namespace
                     RENDERER_LOG_DEBUG("Setting frame to %f", *frameIt);
                     MGlobal::viewFrame(*frameIt);
                 }
+#endif
 
                 const float frame = motionBlurSampleTimes.normalizedFrame(*frameIt);
 
@@ -605,13 +723,17 @@ namespace
                 {
                     if (it->second->supportsMotionBlur())
                     {
-                        if (motionBlurSampleTimes.m_cameraTimes.count(*frameIt))
+                        ScopedProfileEvent nodeEvent(m_profiler, "exportMotionStep", it->first);
+
+                        const AppleseedSession::MotionBlurSampleTimes& objectTimes = it->second->motionBlurSampleTimes();
+
+                        if (objectTimes.m_cameraTimes.count(*frameIt))
                             it->second->exportCameraMotionStep(frame);
 
-                        if (motionBlurSampleTimes.m_transformTimes.count(*frameIt))
+                        if (objectTimes.m_transformTimes.count(*frameIt))
                             it->second->exportTransformMotionStep(frame);
 
-                        if (motionBlurSampleTimes.m_deformTimes.count(*frameIt))
+                        if (objectTimes.m_deformTimes.count(*frameIt))
                             it->second->exportShapeMotionStep(frame);
                     }
 
@@ -621,36 +743,125 @@ namespace
 
             if (autoInstancingEnabled())
             {
+                ScopedProfileEvent profileEvent(m_profiler, "convertObjectsToInstances");
                 RENDERER_LOG_DEBUG("Converting objects to instances");
                 convertObjectsToInstances();
             }
 
             throwIfUserAborted();
 
+            ScopedProfileEvent flushEntitiesEvent(m_profiler, "flushEntities");
+
             RENDERER_LOG_DEBUG("Flushing alpha map entities");
             for (auto it = m_alphaMapExporters.begin(), e = m_alphaMapExporters.end(); it != e; ++it)
+            {
+                ScopedProfileEvent nodeEvent(m_profiler, "flushEntities", it->first);
                 it->second->flushEntities();
+            }
 
             throwIfUserAborted();
 
+            // Identical shader groups are found while the rest of the scene is flushed.
+            // Interactive sessions edit shader groups in place, and cannot share them.
+            const bool shareShaderGroups = m_sessionMode != AppleseedSession::ProgressiveRenderSession;
+            ShaderGroupHasher shaderGroupHasher(m_profiler);
+            std::vector<ShadingNetworkExporter*> hashedNetworks;
+
             RENDERER_LOG_DEBUG("Flushing shading network entities");
             for (size_t i = 0; i < NumShadingNetworkContexts; ++i)
             {
                 for (auto it = m_shadingNetworkExporters[i].begin(), e = m_shadingNetworkExporters[i].end(); it != e; ++it)
+                {
+                    ScopedProfileEvent nodeEvent(m_profiler, "flushEntities", it->first);
                     it->second->flushEntities();
+
+                    if (shareShaderGroups)
+                    {
+                        shaderGroupHasher.submit(it->second->shaderGroup());
+                        hashedNetworks.push_back(it->second.get());
+                    }
+                }
             }
 
             throwIfUserAborted();
 
             RENDERER_LOG_DEBUG("Flushing shading engines entities");
             for (auto it = m_shadingEngineExporters.begin(), e = m_shadingEngineExporters.end(); it != e; ++it)
+            {
+                ScopedProfileEvent nodeEvent(m_profiler, "flushEntities", it->first);
                 it->second->flushEntities();
+            }
 
             throwIfUserAborted();
 
             RENDERER_LOG_DEBUG("Flushing dag entities");
             for (auto it = m_dagExporters.begin(), e = m_dagExporters.end(); it != e; ++it)
+            {
+                ScopedProfileEvent nodeEvent(m_profiler, "flushEntities", it->first);
                 it->second->flushEntities();
+            }
+
+            if (shareShaderGroups)
+                shareIdenticalShaderGroups(shaderGroupHasher, hashedNetworks);
+
+            DagNodeExporter::clearAnimationCache();
+        }
+
+        // appleseed compiles every shader group of the scene before rendering.
+        // Make the networks with identical shader groups share a single one.
+        void shareIdenticalShaderGroups(
+            ShaderGroupHasher&                          hasher,
+            const std::vector<ShadingNetworkExporter*>& networks)
+        {
+            ScopedProfileEvent profileEvent(m_profiler, "shareShaderGroups");
+
+            {
+                ScopedProfileEvent waitEvent(m_profiler, "waitShaderGroupHashes");
+                hasher.wait();
+            }
+
+            std::vector<std::uint64_t> hashes;
+            hashes.reserve(networks.size() * 2);
+            for (const MurmurHash& hash : hasher.hashes())
+            {
+                hashes.push_back(hash.h1());
+                hashes.push_back(hash.h2());
+            }
+
+            std::vector<size_t> masters;
+            findInstanceMasters(hashes.data(), networks.size(), masters);
+
+            std::map<std::string, std::string> sharedNames;
+            for (size_t i = 0, e = networks.size(); i < e; ++i)
+            {
+                if (masters[i] == i)
+                    continue;
+
+                const std::string name = networks[i]->shaderGroupName().asChar();
+                networks[i]->shareShaderGroup(*networks[masters[i]]);
+                sharedNames[name] = networks[i]->shaderGroupName().asChar();
+            }
+
+            if (sharedNames.empty())
+                return;
+
+            // Point the materials to the shared shader groups.
+            asr::Assembly* mainAssembly = m_project->get_scene()->assemblies().get_by_name("assembly");
+            for (asr::Material& material : mainAssembly->materials())
+            {
+                asr::ParamArray& params = material.get_parameters();
+                if (!params.strings().exist("osl_surface"))
+                    continue;
+
+                const auto it = sharedNames.find(params.get<std::string>("osl_surface"));
+                if (it != sharedNames.end())
+                    params.insert("osl_surface", it->second);
+            }
+
+            RENDERER_LOG_INFO(
+                "Shared shader groups: %zu unique out of %zu",
+                networks.size() - sharedNames.size(),
+                networks.size());
         }
 
         void exportDefaultRenderGlobals()
@@ -741,18 +952,17 @@ namespace
         {
             throwIfUserAborted();
 
-            if (m_dagExporters.count(path.fullPathName()) != 0)
+            const NodeKey key(path);
+            if (m_dagExporters.contains(key))
                 return;
 
-            MFnDagNode dagNodeFn(path);
-
-            // Avoid warnings about missing exporter for transform nodes.
-            if (dagNodeFn.typeName() == "transform")
+            // Avoid warnings about missing exporter for transform nodes
+            // and skip Maya's world node, without building type name strings.
+            const MFn::Type apiType = path.apiType();
+            if (apiType == MFn::kTransform || apiType == MFn::kWorld)
                 return;
 
-            // Skip Maya's world node.
-            if (dagNodeFn.typeName() == "dagNode" && dagNodeFn.name() == "world")
-                return;
+            MFnDagNode dagNodeFn(path);
 
             DagNodeExporterPtr exporter;
 
@@ -774,7 +984,7 @@ namespace
 
             if (exporter)
             {
-                m_dagExporters[path.fullPathName()] = exporter;
+                m_dagExporters.set(key, exporter);
                 RENDERER_LOG_DEBUG(
                     "Created dag exporter for node %s",
                     dagNodeFn.name().asChar());
@@ -783,7 +993,8 @@ namespace
 
         void convertObjectsToInstances()
         {
-            std::map<MurmurHash, ShapeExporterPtr> shapesMap;
+            std::vector<DagNodeExporterPtr*> shapes;
+            std::vector<std::uint64_t> hashes;
 
             for (auto it = m_dagExporters.begin(), e = m_dagExporters.end(); it != e; ++it)
             {
@@ -797,26 +1008,69 @@ namespace
                         shape->appleseedName().asChar(),
                         hash.toString().c_str());
 
-                    // Check if we have exported this object before.
-                    auto masterIt = shapesMap.find(hash);
-                    if (masterIt != shapesMap.end())
-                    {
-                        // Create an instance exporter.
-                        DagNodeExporterPtr instanceExporter(
-                            new InstanceExporter(
-                                shape->dagPath(),
-                                m_sessionMode,
-                                *masterIt->second,
-                                *m_project,
-                                shape->transformSequence()));
-
-                        // Replace the shape exporter by an instance exporter.
-                        m_dagExporters[it->first] = instanceExporter;
-                    }
-                    else
-                        shapesMap[hash] = std::dynamic_pointer_cast<ShapeExporter>(it->second);
+                    shapes.push_back(&it->second);
+                    hashes.push_back(hash.h1());
+                    hashes.push_back(hash.h2());
                 }
             }
+
+            // Find the first exported object for each hash.
+            std::vector<size_t> masters;
+            findInstanceMasters(hashes.data(), shapes.size(), masters);
+
+            for (size_t i = 0, e = shapes.size(); i < e; ++i)
+            {
+                if (masters[i] == i)
+                    continue;
+
+                const ShapeExporter& shape = static_cast<const ShapeExporter&>(**shapes[i]);
+                const ShapeExporter& master = static_cast<const ShapeExporter&>(**shapes[masters[i]]);
+
+                // Create an instance exporter.
+                DagNodeExporterPtr instanceExporter(
+                    new InstanceExporter(
+                        shape.dagPath(),
+                        m_sessionMode,
+                        master,
+                        *m_project,
+                        shape.transformSequence()));
+
+                // Replace the shape exporter by an instance exporter.
+                *shapes[i] = instanceExporter;
+            }
+        }
+
+        void startProfiling(const MObject& globals)
+        {
+            if (globals.isNull() || !RenderGlobalsNode::profileExport(globals))
+                return;
+
+            m_profiler.setEnabled(true);
+            m_profiler.setThreadName("main");
+
+            const MString filename = RenderGlobalsNode::profileFilename(globals);
+
+            if (filename.length() != 0)
+                m_profileFilename = filename.asChar();
+            else if (m_fileName.length() != 0)
+            {
+                // Save the trace next to the exported project.
+                bfs::path path(m_fileName.asChar());
+                path.replace_extension(".trace.json");
+                m_profileFilename = path.string();
+            }
+            else
+                m_profileFilename = (bfs::temp_directory_path() / "appleseedmaya_export.trace.json").string();
+        }
+
+        void finishProfiling()
+        {
+            if (!m_profiler.isEnabled())
+                return;
+
+            m_profiler.logSummary();
+            m_profiler.writeChromeTrace(m_profileFilename);
+            m_profiler.setEnabled(false);
         }
 
         void initFileLogging(MObject& globals, ScopedLogTarget& logTarget) const
@@ -864,19 +1118,16 @@ namespace
                 new RenderViewTileCallbackFactory(m_rendererController, m_computation));
             m_tileCallbackFactory->renderViewStart(*m_project->get_frame());
 
-            // Create the master renderer.
-            asr::Configuration* cfg = m_project->configurations().get_by_name("final");
-            const asr::ParamArray& params = cfg->get_parameters();
-            m_renderer.reset(
-                new asr::MasterRenderer(
-                    *m_project,
-                    params,
-                    g_resourceSearchPaths,
-                    static_cast<asr::ITileCallbackFactory*>(m_tileCallbackFactory.get())));
-
-            // Render in a thread (non blocking).
-            std::thread thread(&SessionImpl::renderFunc, this);
+            // Create the master renderer and render in a thread (non blocking).
+            std::thread thread(
+                &SessionImpl::renderFunc,
+                this,
+                tileCallbackFactory(m_tileCallbackFactory.get()));
             m_renderThread.swap(thread);
+
+            // Only reads the exported entities, so it can overlap with
+            // the renderer setting up the scene.
+            collectMemoryUsage();
         }
 
         void batchRender()
@@ -896,6 +1147,20 @@ namespace
             m_rendererController.set_status(asr::IRendererController::ContinueRendering);
 
             // Create the master renderer.
+            createMasterRenderer(tileCallbackFactory(nullptr));
+
+            // Render in the main thread (blocking).
+            {
+                ScopedProfileEvent profileEvent(m_profiler, "render");
+                m_renderer->render(m_rendererController);
+            }
+
+            collectMemoryUsage();
+        }
+
+        void createMasterRenderer(asr::ITileCallbackFactory* tileCallbackFactory)
+        {
+            ScopedProfileEvent profileEvent(m_profiler, "createMasterRenderer");
             asr::Configuration* cfg = m_project->configurations().get_by_name("final");
             const asr::ParamArray& params = cfg->get_parameters();
             m_renderer.reset(
@@ -903,10 +1168,18 @@ namespace
                     *m_project,
                     params,
                     g_resourceSearchPaths,
-                    static_cast<asr::ITileCallbackFactory*>(nullptr)));
+                    tileCallbackFactory));
+        }
 
-            // Render in the main thread (blocking).
-            m_renderer->render(m_rendererController);
+        // Wrap the tile callback factory to time the first pixel when profiling.
+        asr::ITileCallbackFactory* tileCallbackFactory(asr::ITileCallbackFactory* factory)
+        {
+            if (!m_profiler.isEnabled())
+                return factory;
+
+            m_profiledTileCallbackFactory.reset(
+                new ProfiledTileCallbackFactory(m_profiler, factory));
+            return m_profiledTileCallbackFactory.get();
         }
 
         void progressiveRender()
@@ -924,9 +1197,17 @@ namespace
             */
         }
 
-        void renderFunc()
+        void renderFunc(asr::ITileCallbackFactory* tileCallbackFactory)
         {
-            m_renderer->render(m_rendererController);
+            m_profiler.setThreadName("render");
+
+            createMasterRenderer(tileCallbackFactory);
+
+            {
+                ScopedProfileEvent profileEvent(m_profiler, "render");
+                m_renderer->render(m_rendererController);
+            }
+
             IdleJobQueue::pushJob(&AppleseedSession::endSession);
         }
 
@@ -940,6 +1221,54 @@ namespace
                 m_renderThread.join();
         }
 
+        void prefetchTextures()
+        {
+            auto prefetchFiles = [this](const MemoryUsage& usage)
+            {
+                for (const auto& file : usage.files())
+                    m_texturePrefetcher.prefetch(file.second);
+            };
+
+            for (auto it = m_alphaMapExporters.begin(), e = m_alphaMapExporters.end(); it != e; ++it)
+                prefetchFiles(it->second->memoryUsage());
+
+            for (size_t i = 0; i < NumShadingNetworkContexts; ++i)
+            {
+                for (auto it = m_shadingNetworkExporters[i].begin(), e = m_shadingNetworkExporters[i].end(); it != e; ++it)
+                    prefetchFiles(it->second->memoryUsage());
+            }
+        }
+
+        void collectMemoryUsage()
+        {
+            RENDERER_LOG_DEBUG("Collecting scene memory usage");
+
+            std::string nodeType, nodeName;
+
+            auto addToReport = [&](const NodeKey& key, const MemoryUsage& usage)
+            {
+                if (usage.totalBytes() != 0 || !usage.files().empty())
+                {
+                    getNodeTypeAndName(key, nodeType, nodeName);
+                    m_memoryReport.add(nodeType, nodeName, usage);
+                }
+            };
+
+            for (auto it = m_alphaMapExporters.begin(), e = m_alphaMapExporters.end(); it != e; ++it)
+                addToReport(it->first, it->second->memoryUsage());
+
+            for (size_t i = 0; i < NumShadingNetworkContexts; ++i)
+            {
+                for (auto it = m_shadingNetworkExporters[i].begin(), e = m_shadingNetworkExporters[i].end(); it != e; ++it)
+                    addToReport(it->first, it->second->memoryUsage());
+            }
+
+            for (auto it = m_dagExporters.begin(), e = m_dagExporters.end(); it != e; ++it)
+                addToReport(it->first, it->second->memoryUsage());
+
+            m_memoryReport.logSummary(MaxMemoryReportNodesInLog);
+        }
+
         asf::AABB3d computeSceneBoundingBox() const
         {
             asf::AABB3d bbox;
@@ -961,6 +1290,8 @@ namespace
 
         bool writeProject(const char* filename) const
         {
+            ScopedProfileEvent profileEvent(m_profiler, "writeProject");
+
             if (m_options.m_writeBoundingBox)
             {
                 // Save the bounding box of the scene.
@@ -973,6 +1304,10 @@ namespace
                 ofs << "bounds = ["
                     << bbox.min.x << ", " << bbox.min.y << ", " << bbox.min.z << ", "
                     << bbox.max.x << ", " << bbox.max.y << ", " << bbox.max.z << "]";
+
+                // Save the memory usage of the scene next to it.
+                path.replace_extension(".memory.json");
+                m_memoryReport.writeJSON(path.string(), MaxMemoryReportNodesInFile);
             }
 
             const bool packed = asf::ends_with(filename, ".appleseedz");
@@ -1003,11 +1338,11 @@ namespace
                 m_computation->thowIfInterruptRequested();
         }
 
-        typedef std::map<MString, DagNodeExporterPtr, MStringCompareLess>           DagExporterMap;
-        typedef std::map<MString, ShadingEngineExporterPtr, MStringCompareLess>     ShadingEngineExporterMap;
-        typedef std::map<MString, ShadingNetworkExporterPtr, MStringCompareLess>    ShadingNetworkExporterMap;
+        typedef NodeMap<DagNodeExporterPtr>                                         DagExporterMap;
+        typedef NodeMap<ShadingEngineExporterPtr>                                   ShadingEngineExporterMap;
+        typedef NodeMap<ShadingNetworkExporterPtr>                                  ShadingNetworkExporterMap;
         typedef std::array<ShadingNetworkExporterMap, NumShadingNetworkContexts>    ShadingNetworkExporterMapArray;
-        typedef std::map<MString, AlphaMapExporterPtr, MStringCompareLess>          AlphaMapExporterMap;
+        typedef NodeMap<AlphaMapExporterPtr>                                        AlphaMapExporterMap;
 
         AppleseedSession::SessionMode                           m_sessionMode;
         AppleseedSession::Options                               m_options;
@@ -1020,6 +1355,12 @@ namespace
 
         MString                                                 m_fileName;
         bfs::path                                               m_projectPath;
+        bfs::path                                               m_temporaryDirectory;
+
+        MemoryReport                                            m_memoryReport;
+        TexturePrefetcher                                       m_texturePrefetcher;
+        mutable ExportProfiler                                  m_profiler;
+        std::string                                             m_profileFilename;
 
         DagExporterMap                                          m_dagExporters;
         ShadingEngineExporterMap                                m_shadingEngineExporters;
@@ -1029,6 +1370,7 @@ namespace
         std::unique_ptr<asr::MasterRenderer>                    m_renderer;
         RendererController                                      m_rendererController;
         asf::auto_release_ptr<RenderViewTileCallbackFactory>    m_tileCallbackFactory;
+        asf::auto_release_ptr<ProfiledTileCallbackFactory>      m_profiledTileCallbackFactory;
 
         std::thread                                             m_renderThread;
     };
@@ -1327,19 +1669,15 @@ MStatus batchRender(Options options)
 namespace
 {
 
-bool doExportSwatch(
-    asr::Project&               project,
+asf::auto_release_ptr<asr::ShaderGroup> doExportSwatch(
     const MObject&              node,
     const MPlug&                outputPlug,
     const ShadingNetworkContext context)
 {
-    asr::Scene* scene = project.get_scene();
-    assert(scene);
-
-    asr::Assembly* ass = scene->assemblies().get_by_name("assembly");
-    assert(ass);
-
-    ass->shader_groups().clear();
+    // Export the network into a scratch assembly, so that swatches
+    // can be exported while other swatches are being rendered.
+    asf::auto_release_ptr<asr::Assembly> ass(
+        asr::AssemblyFactory().create("swatch_assembly", asr::ParamArray()));
 
     ShadingNetworkExporterPtr exporter(NodeExporterFactory::createShadingNetworkExporter(
         context,
@@ -1351,31 +1689,32 @@ bool doExportSwatch(
     exporter->createEntities();
     exporter->flushEntities();
 
-    asr::Material* material = ass->materials().get_by_index(0);
-    assert(material);
+    asr::ShaderGroup* shaderGroup =
+        ass->shader_groups().get_by_name(exporter->shaderGroupName().asChar());
+
+    if (shaderGroup == nullptr)
+        return asf::auto_release_ptr<asr::ShaderGroup>();
 
-    material->get_parameters().insert("osl_surface", exporter->shaderGroupName().asChar());
-    return true;
+    return ass->shader_groups().remove(shaderGroup);
 }
 
 }
 
-bool exportMaterialSwatch(asr::Project& project, const MObject& node)
+asf::auto_release_ptr<asr::ShaderGroup> exportMaterialSwatch(const MObject& node)
 {
     MFnDependencyNode depNodeFn(node);
     MPlug outputPlug = depNodeFn.findPlug("outColor", /*wantNetworkedPlug=*/ false);
 
     if (outputPlug.isNull())
-        return false;
+        return asf::auto_release_ptr<asr::ShaderGroup>();
 
     return doExportSwatch(
-        project,
         node,
         outputPlug,
         SurfaceSwatchNetworkContext);
 }
 
-bool exportTextureSwatch(asr::Project& project, const MObject& node)
+asf::auto_release_ptr<asr::ShaderGroup> exportTextureSwatch(const MObject& node)
 {
     MFnDependencyNode depNodeFn(node);
 
@@ -1388,10 +1727,9 @@ bool exportTextureSwatch(asr::Project& project, const MObject& node)
 
     // Give up if we don't have a plug.
     if (outputPlug.isNull())
-        return false;
+        return asf::auto_release_ptr<asr::ShaderGroup>();
 
     return doExportSwatch(
-        project,
         node,
         outputPlug,
         TextureSwatchNetworkContext);
@@ -1427,4 +1765,11 @@ const Options& options()
     return g_globalSession->m_options;
 }
 
+std::string temporaryDirectory()
+{
+    assert(g_globalSession.get());
+
+    return g_globalSession->temporaryDirectory().string();
+}
+
 } // namespace AppleseedSession.
@@ -39,6 +39,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/memory/autoreleaseptr.h"
 
 // Maya headers.
 #include "appleseedmaya/_beginmayaheaders.h"
@@ -50,9 +51,11 @@
 
 // Standard headers.
 #include <set>
+#include <string>
 
 // Forward declarations.
 namespace renderer { class Project; }
+namespace renderer { class ShaderGroup; }
 
 namespace AppleseedSession
 {
@@ -159,8 +162,10 @@ MStatus render(const Options& options);
 MStatus batchRender(Options options);
 
 // Swatch rendering.
-bool exportMaterialSwatch(renderer::Project& project, const MObject& node);
-bool exportTextureSwatch(renderer::Project& project, const MObject& node);
+// Export the shading network of a node to a standalone shader group.
+// Returns an empty pointer if the network could not be exported.
+foundation::auto_release_ptr<renderer::ShaderGroup> exportMaterialSwatch(const MObject& node);
+foundation::auto_release_ptr<renderer::ShaderGroup> exportTextureSwatch(const MObject& node);
 
 // Stop rendering and free resources.
 void endSession();
@@ -171,5 +176,10 @@ SessionMode sessionMode();
 // Return the currently active session options.
 const Options& options();
 
+// Return a temporary directory owned by the currently active session.
+// It is created on first use, and removed with its contents when the
+// session ends. Returns an empty string if it could not be created.
+std::string temporaryDirectory();
+
 } // namespace AppleseedSession.
 
@@ -117,3 +117,13 @@ const char*AlphaMapExporter::textureInstanceName() const
 {
     return m_textureInstance->get_name();
 }
+
+MemoryUsage AlphaMapExporter::memoryUsage() const
+{
+    MemoryUsage usage;
+
+    if (m_texture.get())
+        addTextureFileMemoryUsage(m_texture->get_parameters().get("filename"), usage);
+
+    return usage;
+}
@@ -33,6 +33,7 @@
 
 // appleseed-maya headers.
 #include "appleseedmaya/appleseedsession.h"
+#include "appleseedmaya/memoryreport.h"
 #include "appleseedmaya/utils.h"
 
 // Build options header.
@@ -73,6 +74,9 @@ class AlphaMapExporter
 
     const char* textureInstanceName() const;
 
+    // Memory used by the flushed entities.
+    MemoryUsage memoryUsage() const;
+
   private:
     AlphaMapExporter(
       const MObject&                object,
@@ -202,8 +202,9 @@ void CameraExporter::createEntities(
 
 void CameraExporter::exportCameraMotionStep(float time)
 {
-    asf::Matrix4d m = convert(dagPath().inclusiveMatrix());
-    asf::Matrix4d invM = convert(dagPath().inclusiveMatrixInverse());
+    const MMatrix worldM = worldMatrix();
+    asf::Matrix4d m = convert(worldM);
+    asf::Matrix4d invM = convert(worldM.inverse());
     asf::Transformd xform(m, invM);
     m_camera->transform_sequence().set_transform(time, xform);
 }
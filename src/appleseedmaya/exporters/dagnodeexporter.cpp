@@ -39,19 +39,52 @@
 #include "renderer/api/project.h"
 #include "renderer/api/scene.h"
 
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+
 // Maya headers.
 #include "appleseedmaya/_beginmayaheaders.h"
 #include <maya/MAnimUtil.h>
 #include <maya/MBoundingBox.h>
+#if MAYA_API_VERSION >= 201800
+#include <maya/MDGContext.h>
+#include <maya/MDGContextGuard.h>
+#endif
 #include <maya/MFnDagNode.h>
 #include <maya/MFnExpression.h>
+#include <maya/MFnMatrixData.h>
 #include <maya/MGlobal.h>
 #include <maya/MItDependencyGraph.h>
+#include <maya/MObjectHandle.h>
+#include <maya/MPoint.h>
+#include <maya/MTime.h>
 #include "appleseedmaya/_endmayaheaders.h"
 
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
 namespace asf = foundation;
 namespace asr = renderer;
 
+namespace
+{
+    enum MotionBlurSamplesMode
+    {
+        UseGlobalMotionBlurSamples = 0,
+        CustomMotionBlurSamples,
+        AdaptiveMotionBlurSamples
+    };
+
+    const size_t MaxAdaptiveMotionBlurSamples = 16;
+
+    // Number of intervals the shutter is split into to probe the motion of objects.
+    const size_t AdaptiveMotionBlurProbeCount = 8;
+}
+
 DagNodeExporter::DagNodeExporter(
     const MDagPath&                 path,
     asr::Project&                   project,
@@ -114,11 +147,148 @@ void DagNodeExporter::exportShapeMotionStep(float time)
 {
 }
 
+void DagNodeExporter::initializeMotionBlurSampleTimes(
+    const AppleseedSession::MotionBlurSampleTimes&  globalSampleTimes)
+{
+    m_motionBlurSampleTimes = globalSampleTimes;
+
+    // Nothing to override without motion blur.
+    if (globalSampleTimes.m_shutterOpenTime == globalSampleTimes.m_shutterCloseTime)
+        return;
+
+    int mode = UseGlobalMotionBlurSamples;
+    AttributeUtils::get(node(), "asMotionBlurSamplesMode", mode);
+
+    if (mode == UseGlobalMotionBlurSamples)
+        return;
+
+    int transformSamples = 2;
+    AttributeUtils::get(node(), "asTransformMotionSamples", transformSamples);
+
+    int deformSamples = 2;
+    AttributeUtils::get(node(), "asDeformMotionSamples", deformSamples);
+
+    if (mode == AdaptiveMotionBlurSamples)
+    {
+        float tolerance = 0.001f;
+        AttributeUtils::get(node(), "asMotionBlurTolerance", tolerance);
+
+        transformSamples = static_cast<int>(adaptiveTransformSampleCount(globalSampleTimes, tolerance));
+
+        // Deformation keys identical to the rest pose are skipped by the shape
+        // exporters, keep the render settings for deformations.
+        deformSamples = static_cast<int>(globalSampleTimes.m_deformTimes.size());
+    }
+
+    // Deformation samples must be a power of 2, as in the render settings.
+    deformSamples = std::max(deformSamples, 1);
+    if (!asf::is_pow2(deformSamples))
+        deformSamples = asf::next_pow2(deformSamples);
+
+    m_motionBlurSampleTimes.initializeFrameSet(
+        static_cast<size_t>(std::max(transformSamples, 1)),
+        m_motionBlurSampleTimes.m_shutterOpenTime,
+        m_motionBlurSampleTimes.m_shutterCloseTime,
+        m_motionBlurSampleTimes.m_transformTimes);
+
+    m_motionBlurSampleTimes.initializeFrameSet(
+        static_cast<size_t>(deformSamples),
+        m_motionBlurSampleTimes.m_shutterOpenTime,
+        m_motionBlurSampleTimes.m_shutterCloseTime,
+        m_motionBlurSampleTimes.m_deformTimes);
+
+    m_motionBlurSampleTimes.mergeTimes();
+}
+
+const AppleseedSession::MotionBlurSampleTimes& DagNodeExporter::motionBlurSampleTimes() const
+{
+    return m_motionBlurSampleTimes;
+}
+
+size_t DagNodeExporter::adaptiveTransformSampleCount(
+    const AppleseedSession::MotionBlurSampleTimes&  globalSampleTimes,
+    const float                                     tolerance) const
+{
+#if MAYA_API_VERSION >= 201800
+    const double openTime = globalSampleTimes.m_shutterOpenTime;
+    const double closeTime = globalSampleTimes.m_shutterCloseTime;
+
+    // Sample the shutter at the global transform sample times and at a few
+    // interior times, so that periodic motion lining up with some of them,
+    // like a prop spinning full turns within the shutter, is still detected.
+    std::set<double> times;
+    times.insert(openTime);
+    times.insert(closeTime);
+    times.insert(globalSampleTimes.m_transformTimes.begin(), globalSampleTimes.m_transformTimes.end());
+    for (size_t i = 1; i < AdaptiveMotionBlurProbeCount; ++i)
+        times.insert(openTime + (closeTime - openTime) * i / AdaptiveMotionBlurProbeCount);
+
+    std::vector<double> sampleTimes(times.begin(), times.end());
+    std::vector<MMatrix> matrices(sampleTimes.size());
+    for (size_t i = 0, e = sampleTimes.size(); i < e; ++i)
+    {
+        MDGContext context(MTime(sampleTimes[i], MTime::uiUnit()));
+        MDGContextGuard contextGuard(context);
+        matrices[i] = worldMatrix();
+    }
+
+    if (std::all_of(
+            matrices.begin(),
+            matrices.end(),
+            [&matrices](const MMatrix& m) { return m == matrices[0]; }))
+        return 1;
+
+    // Measure how far the corners of the bounding box at each interior sample
+    // are from the linear interpolation of the shutter endpoints. This error
+    // decreases with the square of the number of motion segments.
+    const MBoundingBox bbox = MFnDagNode(dagPath()).boundingBox();
+    const double size = bbox.min().distanceTo(bbox.max());
+    if (size == 0.0)
+        return 2;
+
+    const MMatrix& openMatrix = matrices.front();
+    const MMatrix& closeMatrix = matrices.back();
+
+    double error = 0.0;
+    for (size_t j = 1, je = sampleTimes.size() - 1; j < je; ++j)
+    {
+        const double t = (sampleTimes[j] - openTime) / (closeTime - openTime);
+
+        for (int i = 0; i < 8; ++i)
+        {
+            const MPoint p(
+                i & 1 ? bbox.max().x : bbox.min().x,
+                i & 2 ? bbox.max().y : bbox.min().y,
+                i & 4 ? bbox.max().z : bbox.min().z);
+
+            const MPoint p0 = p * openMatrix;
+            const MPoint p1 = p * closeMatrix;
+            const MPoint lerped = p0 + t * (p1 - p0);
+
+            error = std::max(error, (p * matrices[j]).distanceTo(lerped) / size);
+        }
+    }
+
+    const size_t segments =
+        static_cast<size_t>(std::ceil(std::sqrt(error / std::max(tolerance, 1.0e-6f))));
+
+    return asf::clamp<size_t>(segments + 1, 2, MaxAdaptiveMotionBlurSamples);
+#else
+    // Time contexts are not available, keep the render settings.
+    return globalSampleTimes.m_transformTimes.size();
+#endif
+}
+
 asf::AABB3d DagNodeExporter::boundingBox() const
 {
     return asf::AABB3d();
 }
 
+MemoryUsage DagNodeExporter::memoryUsage() const
+{
+    return MemoryUsage();
+}
+
 asf::AABB3d DagNodeExporter::objectSpaceBoundingBox(const MDagPath& path)
 {
     MFnDagNode dagNodeFn(path);
@@ -152,6 +322,26 @@ asf::Matrix4d DagNodeExporter::convert(const MMatrix& m) const
     return result;
 }
 
+MMatrix DagNodeExporter::worldMatrix() const
+{
+    // Reading the plug, unlike MDagPath::inclusiveMatrix,
+    // honors the time of the current DG context.
+    MStatus status;
+    MFnDagNode dagNodeFn(dagPath());
+    MPlug plug = dagNodeFn.findPlug("worldMatrix", /*wantNetworkedPlug=*/ false, &status);
+
+    if (status)
+    {
+        plug = plug.elementByLogicalIndex(dagPath().instanceNumber());
+        MFnMatrixData matrixDataFn(plug.asMObject(), &status);
+
+        if (status)
+            return matrixDataFn.matrix();
+    }
+
+    return dagPath().inclusiveMatrix();
+}
+
 void DagNodeExporter::addVisibilityAttributesToParams(asr::ParamArray& params)
 {
     asf::Dictionary visFlags;
@@ -236,9 +426,106 @@ namespace
         MObject node;
         bool    checkParent;
     };
+
+    //
+    // Memoization of the animation analysis.
+    //
+    //  Shapes sharing a rig share most of their history, so the results
+    //  of MAnimUtil::isAnimated for history nodes and of isAnimated for
+    //  exported objects are reused during an export. History nodes whose
+    //  whole upstream graph was found static are recorded too, and the
+    //  history walks of the following objects stop at them. The tables
+    //  are keyed by node handle, and only used from the main thread.
+    //
+
+    class AnimationCache
+    {
+      public:
+        bool find(const MObject& node, const bool checkParent, bool& animated) const
+        {
+            MObjectHandle handle(node);
+            const auto range = m_entries.equal_range(handle.hashCode());
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second.m_handle == handle && it->second.m_checkParent == checkParent)
+                {
+                    animated = it->second.m_animated;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void insert(const MObject& node, const bool checkParent, const bool animated)
+        {
+            const Entry entry = {MObjectHandle(node), checkParent, animated};
+            m_entries.emplace(entry.m_handle.hashCode(), entry);
+        }
+
+        void clear()
+        {
+            m_entries.clear();
+        }
+
+      private:
+        struct Entry
+        {
+            MObjectHandle   m_handle;
+            bool            m_checkParent;
+            bool            m_animated;
+        };
+
+        std::unordered_multimap<unsigned int, Entry>    m_entries;
+    };
+
+    AnimationCache g_animatedObjects;
+    AnimationCache g_animatedHistoryNodes;
+    AnimationCache g_staticUpstreamNodes;
+
+    // Upstream graphs are keyed by the checkParent flag of the walk that visited them.
+    // A graph static with the parents checked is static without them too.
+    bool isUpstreamKnownStatic(const MObject& node, const bool checkParent)
+    {
+        bool animated;
+        return
+            g_staticUpstreamNodes.find(node, true, animated) ||
+            (!checkParent && g_staticUpstreamNodes.find(node, false, animated));
+    }
+
+    bool isHistoryNodeAnimated(const MObject& node, const bool checkParent)
+    {
+        bool animated;
+        if (!g_animatedHistoryNodes.find(node, checkParent, animated))
+        {
+            animated = MAnimUtil::isAnimated(node, checkParent);
+            g_animatedHistoryNodes.insert(node, checkParent, animated);
+        }
+
+        return animated;
+    }
+}
+
+void DagNodeExporter::clearAnimationCache()
+{
+    g_animatedObjects.clear();
+    g_animatedHistoryNodes.clear();
+    g_staticUpstreamNodes.clear();
 }
 
 bool DagNodeExporter::isAnimated(MObject object, bool checkParent)
+{
+    bool animated;
+    if (!g_animatedObjects.find(object, checkParent, animated))
+    {
+        animated = isHistoryAnimated(object, checkParent);
+        g_animatedObjects.insert(object, checkParent, animated);
+    }
+
+    return animated;
+}
+
+bool DagNodeExporter::isHistoryAnimated(MObject object, bool checkParent)
 {
     MStatus stat;
     MItDependencyGraph iter(
@@ -314,14 +601,22 @@ bool DagNodeExporter::isAnimated(MObject object, bool checkParent)
             nodeStruct.node = node;
             nodeStruct.checkParent = checkParent || checkNodeParent;
             nodesToCheckAnimCurve.push_back(nodeStruct);
+
+            // Don't walk history already found static for another object.
+            if (isUpstreamKnownStatic(node, checkParent))
+                iter.prune();
         }
     }
 
     for (size_t i = 0, e = nodesToCheckAnimCurve.size(); i < e; ++i)
     {
-        if (MAnimUtil::isAnimated(nodesToCheckAnimCurve[i].node, nodesToCheckAnimCurve[i].checkParent))
+        if (isHistoryNodeAnimated(nodesToCheckAnimCurve[i].node, nodesToCheckAnimCurve[i].checkParent))
             return true;
     }
 
+    // The whole walk was static, and so is the upstream graph of every visited node.
+    for (size_t i = 0, e = nodesToCheckAnimCurve.size(); i < e; ++i)
+        g_staticUpstreamNodes.insert(nodesToCheckAnimCurve[i].node, checkParent, false);
+
     return false;
 }
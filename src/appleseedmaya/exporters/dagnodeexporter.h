@@ -33,6 +33,7 @@
 
 // appleseed-maya headers.
 #include "appleseedmaya/appleseedsession.h"
+#include "appleseedmaya/memoryreport.h"
 #include "appleseedmaya/utils.h"
 
 // Build options header.
@@ -72,6 +73,9 @@ class DagNodeExporter
     // Destructor.
     virtual ~DagNodeExporter();
 
+    // Forget the results of the animation analysis of previous exports.
+    static void clearAnimationCache();
+
     // Return the Maya dependency node.
     MObject node() const;
 
@@ -84,6 +88,14 @@ class DagNodeExporter
     // Return true if the entity created by this exporter can be motion blurred.
     virtual bool supportsMotionBlur() const;
 
+    // Compute the motion blur sample times of this object from the global ones,
+    // taking per object overrides into account.
+    void initializeMotionBlurSampleTimes(
+        const AppleseedSession::MotionBlurSampleTimes&  globalSampleTimes);
+
+    // Return the motion blur sample times of this object.
+    const AppleseedSession::MotionBlurSampleTimes& motionBlurSampleTimes() const;
+
     // Create any extra exporter needed by this exporter (shading engines, ...).
     virtual void createExporters(const AppleseedSession::IExporterFactory& exporter_factory);
 
@@ -103,6 +115,9 @@ class DagNodeExporter
     // Bounds.
     virtual foundation::AABB3d boundingBox() const;
 
+    // Memory used by the flushed entities.
+    virtual MemoryUsage memoryUsage() const;
+
   protected:
     // Constructor.
     DagNodeExporter(
@@ -125,6 +140,9 @@ class DagNodeExporter
     // Convert a Maya matrix to an appleseed matrix.
     foundation::Matrix4d convert(const MMatrix& m) const;
 
+    // Return the world matrix of the dag path, evaluated in the current DG context.
+    MMatrix worldMatrix() const;
+
     // Add appleseed visibility attributes to the ParamArray.
     void addVisibilityAttributesToParams(renderer::ParamArray& params);
 
@@ -135,6 +153,7 @@ class DagNodeExporter
     static bool areObjectAndParentsRenderable(const MDagPath& path);
 
     // Return true if an object is animated.
+    // Results are memoized until clearAnimationCache is called.
     static bool isAnimated(MObject object, bool checkParent = false);
 
     // Return the object space bounding box.
@@ -142,10 +161,17 @@ class DagNodeExporter
 
 
   private:
-    MDagPath                      m_path;
-    AppleseedSession::SessionMode m_sessionMode;
-    renderer::Project&            m_project;
-    renderer::Scene&              m_scene;
-    renderer::Assembly&           m_mainAssembly;
+    static bool isHistoryAnimated(MObject object, bool checkParent);
+
+    size_t adaptiveTransformSampleCount(
+        const AppleseedSession::MotionBlurSampleTimes&  globalSampleTimes,
+        const float                                     tolerance) const;
+
+    MDagPath                                    m_path;
+    AppleseedSession::SessionMode               m_sessionMode;
+    renderer::Project&                          m_project;
+    renderer::Scene&                            m_scene;
+    renderer::Assembly&                         m_mainAssembly;
+    AppleseedSession::MotionBlurSampleTimes     m_motionBlurSampleTimes;
 };
 
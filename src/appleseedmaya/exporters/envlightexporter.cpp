@@ -287,7 +287,7 @@ void SkyDomeLightExporter::createEntities(
 
 void SkyDomeLightExporter::exportTransformMotionStep(float time)
 {
-    asf::Matrix4d m = convert(dagPath().inclusiveMatrix());
+    asf::Matrix4d m = convert(worldMatrix());
 
     // Keep only the rotation components of the matrix.
     asf::Vector3d s, t;
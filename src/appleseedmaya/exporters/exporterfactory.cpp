@@ -47,6 +47,7 @@
 #include "appleseedmaya/exporters/shadingengineexporter.h"
 #include "appleseedmaya/exporters/shadingnetworkexporter.h"
 #include "appleseedmaya/exporters/shadingnodeexporter.h"
+#include "appleseedmaya/exporters/shadingnodeexportplan.h"
 #ifdef APPLESEED_MAYA_WITH_XGEN
 #include "appleseedmaya/exporters/xgenexporter.h"
 #endif
@@ -116,6 +117,9 @@ MStatus NodeExporterFactory::initialize(const MString& pluginPath)
 
 MStatus NodeExporterFactory::uninitialize()
 {
+    // Cached export plans hold attributes of node types about to be deregistered.
+    ShadingNodeExportPlan::clear();
+
     return MS::kSuccess;
 }
 
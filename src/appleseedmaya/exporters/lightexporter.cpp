@@ -193,8 +193,9 @@ void LightExporter::createEntities(
     }
 
     m_light = lightFactory->create(appleseedName().asChar(), lightParams);
-    asf::Matrix4d m = convert(dagPath().inclusiveMatrix());
-    asf::Matrix4d invM = convert(dagPath().inclusiveMatrixInverse());
+    const MMatrix worldM = worldMatrix();
+    asf::Matrix4d m = convert(worldM);
+    asf::Matrix4d invM = convert(worldM.inverse());
     asf::Transformd xform(m, invM);
     m_light->set_transform(xform);
 }
@@ -33,11 +33,16 @@
 #include "appleseedmaya/attributeutils.h"
 #include "appleseedmaya/exporters/alphamapexporter.h"
 #include "appleseedmaya/exporters/exporterfactory.h"
+#include "appleseedmaya/geometryconversion.h"
 #include "appleseedmaya/logger.h"
+#include "appleseedmaya/meshutils.h"
 
 // Build options header.
 #include "foundation/core/buildoptions.h"
 
+// appleseed.renderer headers.
+#include "renderer/api/project.h"
+
 // appleseed.foundation headers.
 #include "foundation/string/string.h"
 
@@ -47,10 +52,9 @@
 #include <maya/MFnEnumAttribute.h>
 #include <maya/MFnMesh.h>
 #include <maya/MFnMeshData.h>
+#include <maya/MIntArray.h>
 #include <maya/MItDependencyGraph.h>
-#include <maya/MItMeshPolygon.h>
 #include <maya/MMeshSmoothOptions.h>
-#include <maya/MPointArray.h>
 #include <maya/MString.h>
 #include "appleseedmaya/_endmayaheaders.h"
 
@@ -60,7 +64,10 @@
 #include "boost/filesystem/path.hpp"
 
 // Standard headers
+#include <algorithm>
 #include <array>
+#include <cstdlib>
+#include <vector>
 
 namespace bfs = boost::filesystem;
 namespace asf = foundation;
@@ -94,6 +101,136 @@ namespace
         for (size_t i = 0, e = mesh.get_vertex_tangent_count(); i < e; ++i)
             hash.append(mesh.get_vertex_tangent(i));
     }
+
+    void motionPosesHash(const asr::MeshObject& mesh, MurmurHash& hash)
+    {
+        // Tangent poses are computed from the other poses when the mesh is flushed.
+        hash.append(mesh.get_motion_segment_count());
+        for (size_t p = 0, pe = mesh.get_motion_segment_count(); p < pe; ++p)
+        {
+            hash.append(mesh.get_vertex_count());
+            for (size_t i = 0, e = mesh.get_vertex_count(); i < e; ++i)
+                hash.append(mesh.get_vertex_pose(i, p));
+
+            hash.append(mesh.get_vertex_normal_count());
+            for (size_t i = 0, e = mesh.get_vertex_normal_count(); i < e; ++i)
+                hash.append(mesh.get_vertex_normal_pose(i, p));
+        }
+    }
+
+    // Directory where stand-in geometry is written. Stand-ins written to
+    // APPLESEED_MAYA_STANDIN_PATH are reused across sessions, and are never
+    // removed by the plugin. Otherwise, stand-ins of render sessions are
+    // written to the session temporary directory, removed when the session ends.
+    bfs::path standInDirectory(
+        const asr::Project&             project,
+        AppleseedSession::SessionMode   sessionMode)
+    {
+        bfs::path dir;
+
+        if (sessionMode == AppleseedSession::ExportSession)
+            dir = bfs::path(project.search_paths().get_root_path().c_str()) / "_geometry";
+        else if (const char* standInPath = getenv("APPLESEED_MAYA_STANDIN_PATH"))
+            dir = standInPath;
+        else
+        {
+            dir = AppleseedSession::temporaryDirectory();
+            if (dir.empty())
+                return dir;
+        }
+
+        boost::system::error_code ec;
+        bfs::create_directories(dir, ec);
+        return dir;
+    }
+
+    // Unique temporary filename next to a file, for writing it and renaming it into place.
+    bfs::path temporaryFilename(const bfs::path& path)
+    {
+        boost::system::error_code ec;
+        const bfs::path tmpPath = bfs::unique_path(path.string() + ".%%%%-%%%%.tmp", ec);
+        return ec ? bfs::path() : tmpPath;
+    }
+
+    // Write a mesh file, so that concurrent sessions sharing the
+    // stand-in directory never see a partial file.
+    bool writeStandInMesh(const asr::MeshObject& mesh, const bfs::path& meshPath)
+    {
+        const bfs::path tmpPath = temporaryFilename(meshPath);
+        if (tmpPath.empty())
+            return false;
+
+        boost::system::error_code ec;
+
+        if (asr::MeshObjectWriter::write(mesh, "mesh", tmpPath.string().c_str()))
+        {
+            bfs::rename(tmpPath, meshPath, ec);
+            if (!ec)
+                return true;
+        }
+
+        bfs::remove(tmpPath, ec);
+        return false;
+    }
+
+    // Write an archive holding a single instance of a mesh file.
+    // Relative mesh filenames are resolved from the archive directory.
+    bool writeStandInArchive(
+        const bfs::path&                archivePath,
+        const std::string&              meshFileName,
+        const MString&                  objectName,
+        const asr::ParamArray&          objectParams,
+        const asr::ParamArray&          instanceParams,
+        const asf::StringDictionary&    frontMaterialMappings,
+        const asf::StringDictionary&    backMaterialMappings)
+    {
+        asf::auto_release_ptr<asr::Project> archive(
+            asr::ProjectFactory::create(objectName.asChar()));
+        archive->set_scene(asr::SceneFactory::create());
+
+        asf::auto_release_ptr<asr::Assembly> assembly(
+            asr::AssemblyFactory().create("assembly", asr::ParamArray()));
+
+        asr::ParamArray params = objectParams;
+        params.insert("filename", meshFileName.c_str());
+        assembly->objects().insert(
+            asf::auto_release_ptr<asr::Object>(
+                asr::MeshObjectFactory().create(objectName.asChar(), params)));
+
+        const MString objectInstanceName = objectName + MString("_instance");
+        const MString meshName = objectName + MString(".mesh");
+        assembly->object_instances().insert(
+            asr::ObjectInstanceFactory::create(
+                objectInstanceName.asChar(),
+                instanceParams,
+                meshName.asChar(),
+                asf::Transformd::identity(),
+                frontMaterialMappings,
+                backMaterialMappings));
+
+        archive->get_scene()->assemblies().insert(assembly);
+
+        // Write to a temporary file first, so that concurrent exports never see partial archives.
+        const bfs::path tmpPath = temporaryFilename(archivePath);
+        if (tmpPath.empty())
+            return false;
+
+        boost::system::error_code ec;
+
+        if (asr::ProjectFileWriter::write(
+                archive.ref(),
+                tmpPath.string().c_str(),
+                asr::ProjectFileWriter::OmitHandlingAssetFiles |
+                asr::ProjectFileWriter::OmitWritingGeometryFiles))
+        {
+            bfs::rename(tmpPath, archivePath, ec);
+            if (!ec)
+                return true;
+        }
+
+        bfs::remove(tmpPath, ec);
+        return false;
+    }
 }
 
 void MeshExporter::registerExporter()
@@ -242,8 +379,22 @@ void MeshExporter::createEntities(
 
     m_numMeshKeys = motionBlurSampleTimes.m_deformTimes.size();
     m_isDeforming = (m_numMeshKeys > 1) && isAnimated(node());
+    m_hasMotionKeys = false;
     m_shapeExportStep = 1;
 
+    // Stand-ins are static and can't be edited interactively.
+    m_standIn = false;
+    if (sessionMode() != AppleseedSession::ProgressiveRenderSession)
+        AttributeUtils::get(node(), "asStandIn", m_standIn);
+
+    if (m_standIn && (m_isDeforming || m_alphaMapExporter))
+    {
+        RENDERER_LOG_WARNING(
+            "Mesh %s is deforming or has an alpha map, exporting it as a regular mesh instead of a stand-in.",
+            appleseedName().asChar());
+        m_standIn = false;
+    }
+
     if (sessionMode() != AppleseedSession::ExportSession)
     {
         MString objectName = appleseedName();
@@ -261,6 +412,18 @@ void MeshExporter::exportShapeMotionStep(float time)
     MStatus status;
     MeshAndData finalMesh = getFinalMesh(&status);
 
+    if (m_standIn)
+    {
+        if (exportStandIn(finalMesh.m_mesh))
+        {
+            m_shapeExportStep++;
+            return;
+        }
+
+        // Fallback to a regular mesh if the stand-in could not be written.
+        m_standIn = false;
+    }
+
     if (sessionMode() == AppleseedSession::ExportSession)
     {
         MString objectName = appleseedName();
@@ -342,24 +505,7 @@ void MeshExporter::exportShapeMotionStep(float time)
             m_hash.append(m_backMaterialMappings);
         }
         else
-        {
             exportMeshKey(finalMesh.m_mesh);
-
-            // Update the mesh hash.
-            const size_t pose = m_shapeExportStep - 1;
-
-            m_hash.append(m_mesh->get_vertex_count());
-            for (size_t i = 0, e = m_mesh->get_vertex_count(); i < e; ++i)
-                m_hash.append(m_mesh->get_vertex_pose(i, pose));
-
-            m_hash.append(m_mesh->get_vertex_normal_count());
-            for (size_t i = 0, e = m_mesh->get_vertex_normal_count(); i < e; ++i)
-                m_hash.append(m_mesh->get_vertex_normal_pose(i, pose));
-
-            m_hash.append(m_mesh->get_vertex_tangent_count());
-            for (size_t i = 0, e = m_mesh->get_vertex_tangent_count(); i < e; ++i)
-                m_hash.append(m_mesh->get_vertex_tangent_pose(i, pose));
-        }
     }
 
     m_shapeExportStep++;
@@ -367,6 +513,27 @@ void MeshExporter::exportShapeMotionStep(float time)
 
 void MeshExporter::flushEntities()
 {
+    if (m_standIn)
+    {
+        // The object lives in an archive assembly, expanded by the renderer.
+        m_transformSequence.optimize();
+
+        const asr::AssemblyFactoryRegistrar& assemblyFactories =
+            project().get_factory_registrar<asr::Assembly>();
+
+        const auto factory = assemblyFactories.lookup("archive_assembly");
+        assert(factory);
+
+        const MString assemblyName = appleseedName() + MString("_assembly");
+
+        RENDERER_LOG_DEBUG("Flushing stand-in assembly %s", assemblyName.asChar());
+        insertObjectAssembly(
+            factory->create(
+                assemblyName.asChar(),
+                asr::ParamArray().insert("filename", m_standInFileName.c_str())));
+        return;
+    }
+
     ShapeExporter::flushEntities();
 
     MString objectName = appleseedName();
@@ -375,6 +542,23 @@ void MeshExporter::flushEntities()
     {
         assert(!m_fileNames.empty());
 
+        // Mesh files are named after their contents, identical keys share a file.
+        // Keep a single key if the mesh does not move within the shutter.
+        if (std::all_of(
+                m_fileNames.begin(),
+                m_fileNames.end(),
+                [this](const std::string& fileName) { return fileName == m_fileNames[0]; }))
+            m_fileNames.resize(1);
+
+        // Account for the geometry the renderer will load: the first file is
+        // the mesh, the other ones its motion poses.
+        addMeshObjectMemoryUsage(*m_mesh, m_memoryUsage);
+        m_memoryUsage.add(
+            "mesh motion poses",
+            (m_fileNames.size() - 1) *
+                (m_mesh->get_vertex_count() + m_mesh->get_vertex_normal_count() + m_mesh->get_vertex_tangent_count()) *
+                sizeof(asr::GVector3));
+
         // Replace our MeshObject by one referencing the exported meshes.
         asr::ParamArray params = m_mesh->get_parameters();
 
@@ -405,6 +589,8 @@ void MeshExporter::flushEntities()
             assert(m_exportUVs);
             asr::compute_smooth_vertex_tangents(*m_mesh);
         }
+
+        addMeshObjectMemoryUsage(*m_mesh, m_memoryUsage);
     }
 
     // Handle alpha maps.
@@ -432,7 +618,19 @@ bool MeshExporter::supportsInstancing() const
 
 MurmurHash MeshExporter::hash() const
 {
-    return m_hash;
+    if (m_standIn || sessionMode() == AppleseedSession::ExportSession)
+        return m_hash;
+
+    // Motion poses are only final once every motion step is exported:
+    // skipped keys are filled with the rest pose when the mesh first moves.
+    MurmurHash hash = m_hash;
+    motionPosesHash(*m_mesh, hash);
+    return hash;
+}
+
+MemoryUsage MeshExporter::memoryUsage() const
+{
+    return m_memoryUsage;
 }
 
 // Insert mesh object params here.
@@ -461,13 +659,32 @@ MeshExporter::MeshAndData MeshExporter::getFinalMesh(MStatus* ReturnStatus) cons
 {
     MeshAndData finalMesh = {node(), MObject()};
 
+    // Read the mesh data from the plug, so that it is evaluated
+    // at the time of the current DG context.
+    MStatus status;
+    MFnDependencyNode depNodeFn(node());
+    MPlug plug = depNodeFn.findPlug("outMesh", /*wantNetworkedPlug=*/ false, &status);
+    if (status)
+    {
+#if MAYA_API_VERSION >= 201800
+        MObject meshData = plug.asMObject(&status);
+#else
+        MObject meshData = plug.asMObject(MDGContext::fsNormal, &status);
+#endif
+        if (status && !meshData.isNull())
+        {
+            finalMesh.m_mesh = meshData;
+            finalMesh.m_data = meshData;
+        }
+    }
+
     const int smoothLevel = getSmoothLevel();
     if (smoothLevel > 0)
     {
         // We need to create a smooth mesh.
-        MFnMesh meshFn(node());
+        MFnMesh meshFn(finalMesh.m_mesh);
         MMeshSmoothOptions options;
-        MStatus status = meshFn.getSmoothMeshDisplayOptions(options);
+        status = MFnMesh(node()).getSmoothMeshDisplayOptions(options);
 
         if (!status)
         {
@@ -502,171 +719,244 @@ void MeshExporter::createMaterialSlots()
 
 void MeshExporter::fillTopology(MObject mesh)
 {
-    MStatus status;
-
-    // Triangle buffer.
-    std::vector<asr::Triangle> triangles;
+    MFnMesh meshFn(mesh);
 
-    MIntArray faceVertexIndices;
-    MIntArray faceUVIndices;
-    MIntArray faceNormalIndices;
-    MIntArray triangleVertexIndices;
-    MPointArray trianglePoints;
+    // Fetch the topology in bulk, and match triangles to face vertices
+    // in a single pass over plain arrays.
+    MIntArray faceVertexCounts, faceVertices;
+    meshFn.getVertices(faceVertexCounts, faceVertices);
 
-    MItMeshPolygon faceIt(mesh);
-    for (;!faceIt.isDone(); faceIt.next())
-    {
-        // Get the material index for this face.
-        int materialIndex = 0;
-        if (m_perFaceAssignments.length() != 0)
-            materialIndex = m_perFaceAssignments[faceIt.index()];
+    MIntArray faceTriangleCounts, triangleVertices;
+    meshFn.getTriangles(faceTriangleCounts, triangleVertices);
 
-        // Collect normal and uv indices for this face.
-        faceUVIndices.clear();
-        faceNormalIndices.clear();
+    PolygonMeshTopology topology;
+    topology.m_faceCount = faceVertexCounts.length();
+    topology.m_faceVertexCounts = MeshUtils::intArrayData(faceVertexCounts);
+    topology.m_faceVertices = MeshUtils::intArrayData(faceVertices);
+    topology.m_faceTriangleCounts = MeshUtils::intArrayData(faceTriangleCounts);
+    topology.m_triangleVertices = MeshUtils::intArrayData(triangleVertices);
 
-        faceIt.getVertices(faceVertexIndices);
-        for (unsigned int i = 0, e = faceVertexIndices.length(); i < e; ++i)
-        {
-            if (m_exportUVs)
-            {
-                int uvIndex;
-                status = faceIt.getUVIndex(static_cast<int>(i), uvIndex);
-                faceUVIndices.append(uvIndex);
-            }
+    MIntArray faceUVCounts, faceUVs;
+    if (m_exportUVs)
+    {
+        meshFn.getAssignedUVs(faceUVCounts, faceUVs);
+        topology.m_faceUVCounts = MeshUtils::intArrayData(faceUVCounts);
+        topology.m_faceUVs = MeshUtils::intArrayData(faceUVs);
+    }
 
-            if (m_exportNormals)
-            {
-                unsigned int normalIndex = faceIt.normalIndex(static_cast<int>(i), &status);
-                faceNormalIndices.append(normalIndex);
-            }
-        }
+    MIntArray faceNormalCounts, faceNormals;
+    if (m_exportNormals)
+    {
+        meshFn.getNormalIds(faceNormalCounts, faceNormals);
+        topology.m_faceNormals = MeshUtils::intArrayData(faceNormals);
+    }
 
-        // Match the triangle indices to the face indices.
-        int numTris;
-        faceIt.numTriangles(numTris);
-        for (int i = 0; i < numTris; ++i)
-        {
-            trianglePoints.clear();
-            triangleVertexIndices.clear();
-            faceIt.getTriangle(i, trianglePoints, triangleVertexIndices);
+    if (m_perFaceAssignments.length() != 0)
+        topology.m_faceMaterials = MeshUtils::intArrayData(m_perFaceAssignments);
 
-            int triangleVertexOffset[3] = {-1, -1, -1};
-            for (unsigned int j = 0, je = faceVertexIndices.length(); j < je; ++j)
-            {
-                if (faceVertexIndices[j] == triangleVertexIndices[0])
-                    triangleVertexOffset[0] = j;
-                else if (faceVertexIndices[j] == triangleVertexIndices[1])
-                    triangleVertexOffset[1] = j;
-                else if (faceVertexIndices[j] == triangleVertexIndices[2])
-                    triangleVertexOffset[2] = j;
-            }
+    std::vector<TriangleIndices> triangles;
+    triangulateFaces(topology, triangles);
 
-            asr::Triangle triangle(
-                faceVertexIndices[triangleVertexOffset[0]],
-                faceVertexIndices[triangleVertexOffset[1]],
-                faceVertexIndices[triangleVertexOffset[2]],
-                materialIndex);
+    // Copy triangles to the mesh.
+    m_mesh->reserve_triangles(triangles.size());
+    for (size_t i = 0, e = triangles.size(); i < e; ++i)
+    {
+        const TriangleIndices& t = triangles[i];
 
-            if (m_exportUVs)
-            {
-                triangle.m_a0 = faceUVIndices[triangleVertexOffset[0]];
-                triangle.m_a1 = faceUVIndices[triangleVertexOffset[1]];
-                triangle.m_a2 = faceUVIndices[triangleVertexOffset[2]];
-            }
+        asr::Triangle triangle(t.m_v0, t.m_v1, t.m_v2, t.m_pa);
 
-            if (m_exportNormals)
-            {
-                triangle.m_n0 = faceNormalIndices[triangleVertexOffset[0]];
-                triangle.m_n1 = faceNormalIndices[triangleVertexOffset[1]];
-                triangle.m_n2 = faceNormalIndices[triangleVertexOffset[2]];
-            }
+        if (m_exportUVs)
+        {
+            triangle.m_a0 = t.m_a0;
+            triangle.m_a1 = t.m_a1;
+            triangle.m_a2 = t.m_a2;
+        }
 
-            triangles.push_back(triangle);
+        if (m_exportNormals)
+        {
+            triangle.m_n0 = t.m_n0;
+            triangle.m_n1 = t.m_n1;
+            triangle.m_n2 = t.m_n2;
         }
-    }
 
-    // Copy triangles to the mesh.
-    m_mesh->reserve_triangles(triangles.size());
-    for (size_t i = 0, e = triangles.size(); i < e; ++i)
-        m_mesh->push_triangle(triangles[i]);
+        m_mesh->push_triangle(triangle);
+    }
 }
 
 void MeshExporter::exportGeometry(MObject mesh)
 {
-    MStatus status;
     MFnMesh meshFn(mesh);
 
+    // Maya arrays are converted in bulk to presized buffers,
+    // then appended to the mesh, which has no bulk insertion.
+
     // Vertices.
-    m_mesh->reserve_vertices(meshFn.numVertices());
-    {
-        const float* p = meshFn.getRawPoints(&status);
-        for (size_t i = 0, e = meshFn.numVertices(); i < e; ++i, p += 3)
-            m_mesh->push_vertex(asr::GVector3(p[0], p[1], p[2]));
-    }
+    std::vector<asr::GVector3> points;
+    MeshUtils::copyPoints(meshFn, points);
+
+    m_mesh->reserve_vertices(points.size());
+    for (const asr::GVector3& p : points)
+        m_mesh->push_vertex(p);
 
     if (m_exportUVs)
     {
-        m_mesh->reserve_tex_coords(meshFn.numUVs());
-        MFloatArray u, v;
-        status = meshFn.getUVs(u, v);
-        for (int i = 0, e = meshFn.numUVs(); i < e; ++i)
-            m_mesh->push_tex_coords(asr::GVector2(u[i], v[i]));
+        std::vector<asr::GVector2> uvs;
+        MeshUtils::copyUVs(meshFn, uvs);
+
+        m_mesh->reserve_tex_coords(uvs.size());
+        for (const asr::GVector2& uv : uvs)
+            m_mesh->push_tex_coords(uv);
     }
 
     if (m_exportNormals)
     {
-        const asr::GVector3 Y(0.0f, 1.0f, 0.0f);
-        m_mesh->reserve_vertex_normals(meshFn.numNormals());
-        const float* p = meshFn.getRawNormals(&status);
+        std::vector<asr::GVector3> normals;
+        MeshUtils::copyNormals(meshFn, normals);
+
+        m_mesh->reserve_vertex_normals(normals.size());
+        for (const asr::GVector3& n : normals)
+            m_mesh->push_vertex_normal(n);
+    }
+}
+
+bool MeshExporter::exportStandIn(MObject mesh)
+{
+    const bfs::path dir = standInDirectory(project(), sessionMode());
+    if (dir.empty())
+        return false;
+
+    MString objectName = appleseedName();
+    m_mesh.reset(asr::MeshObjectFactory().create(objectName.asChar(), m_meshParams));
+
+    createMaterialSlots();
+    fillTopology(mesh);
+    exportGeometry(mesh);
+
+    if (m_smoothTangents)
+    {
+        assert(m_exportUVs);
+        asr::compute_smooth_vertex_tangents(*m_mesh);
+    }
+
+    asr::ParamArray instanceParams;
+    objectInstanceAttributesToParams(instanceParams);
 
-        for (int i = 0, e = meshFn.numNormals(); i < e; ++i, p += 3)
+    m_hash = MurmurHash();
+    staticMeshObjectHash(*m_mesh, m_hash);
+    m_hash.append(m_mesh->get_parameters());
+    m_hash.append(instanceParams);
+    m_hash.append(m_frontMaterialMappings);
+    m_hash.append(m_backMaterialMappings);
+
+    const bfs::path meshPath = dir / (m_hash.toString() + ".binarymesh");
+    const bfs::path archivePath = dir / (m_hash.toString() + ".appleseed");
+
+    // Exported projects reference their stand-ins by relative paths,
+    // so that they can be moved or rendered on other machines.
+    const bool relativePaths = sessionMode() == AppleseedSession::ExportSession;
+
+    // Identical stand-ins are written only once, and reused by later exports.
+    if (!bfs::exists(archivePath))
+    {
+        if (!writeStandInMesh(*m_mesh, meshPath) ||
+            !writeStandInArchive(
+                archivePath,
+                relativePaths ? meshPath.filename().string() : meshPath.string(),
+                objectName,
+                m_mesh->get_parameters(),
+                instanceParams,
+                m_frontMaterialMappings,
+                m_backMaterialMappings))
         {
-            asr::GVector3 n(p[0], p[1], p[2]);
-            m_mesh->push_vertex_normal(asf::safe_normalize(n, Y));
+            RENDERER_LOG_ERROR(
+                "Couldn't write stand-in for object %s.",
+                m_mesh->get_name());
+
+            // Start over with an empty mesh.
+            m_mesh.reset(asr::MeshObjectFactory().create(objectName.asChar(), m_meshParams));
+            createMaterialSlots();
+            return false;
         }
     }
+
+    m_standInFileName = relativePaths
+        ? "_geometry/" + archivePath.filename().string()
+        : archivePath.string();
+
+    // The renderer loads the mesh when it expands the archive.
+    addMeshObjectMemoryUsage(*m_mesh, m_memoryUsage);
+
+    // Only the file reference is kept in memory.
+    m_mesh.reset();
+    return true;
 }
 
 void MeshExporter::exportMeshKey(MObject mesh)
 {
-    MStatus status;
     MFnMesh meshFn(mesh);
 
-    if (m_shapeExportStep == 1)
+    assert(m_isDeforming);
+    assert(m_numMeshKeys > 1);
+
+    // The first motion pose is the second mesh key.
+    const size_t pose = m_shapeExportStep - 2;
+
+    std::vector<asr::GVector3> points;
+    MeshUtils::copyPoints(meshFn, points);
+
+    std::vector<asr::GVector3> normals;
+    if (m_exportNormals)
+        MeshUtils::copyNormals(meshFn, normals);
+
+    if (!m_hasMotionKeys)
     {
-        assert(m_isDeforming);
-        assert(m_numMeshKeys > 1);
+        // Keys identical to the rest pose are not stored,
+        // until the mesh actually moves within the shutter.
+        if (isRestPose(points, normals))
+            return;
 
-        // Reserve number of keys.
+        // Motion segments are evenly spaced, so the skipped keys are
+        // filled with the rest pose.
         m_mesh->set_motion_segment_count(m_numMeshKeys - 1);
-    }
 
-    // Vertices.
-    {
-        const float* p = meshFn.getRawPoints(&status);
-        for (size_t i = 0, e = meshFn.numVertices(); i < e; ++i, p += 3)
+        for (size_t p = 0; p < pose; ++p)
         {
-            m_mesh->set_vertex_pose(
-                i,
-                m_shapeExportStep - 1,
-                asr::GVector3(p[0], p[1], p[2]));
+            for (size_t i = 0, e = m_mesh->get_vertex_count(); i < e; ++i)
+                m_mesh->set_vertex_pose(i, p, m_mesh->get_vertex(i));
+
+            for (size_t i = 0, e = m_mesh->get_vertex_normal_count(); i < e; ++i)
+                m_mesh->set_vertex_normal_pose(i, p, m_mesh->get_vertex_normal(i));
         }
+
+        m_hasMotionKeys = true;
     }
 
-    if (m_exportNormals)
+    for (size_t i = 0, e = points.size(); i < e; ++i)
+        m_mesh->set_vertex_pose(i, pose, points[i]);
+
+    for (size_t i = 0, e = normals.size(); i < e; ++i)
+        m_mesh->set_vertex_normal_pose(i, pose, normals[i]);
+}
+
+bool MeshExporter::isRestPose(
+    const std::vector<asr::GVector3>&   points,
+    const std::vector<asr::GVector3>&   normals) const
+{
+    if (points.size() != m_mesh->get_vertex_count() ||
+        normals.size() != (m_exportNormals ? m_mesh->get_vertex_normal_count() : 0))
+        return false;
+
+    for (size_t i = 0, e = points.size(); i < e; ++i)
     {
-        const asr::GVector3 Y(0.0f, 1.0f, 0.0f);
-        m_mesh->reserve_vertex_normals(meshFn.numNormals());
-        const float* p = meshFn.getRawNormals(&status);
+        if (points[i] != m_mesh->get_vertex(i))
+            return false;
+    }
 
-        for (size_t i = 0, e = meshFn.numNormals(); i < e; ++i, p += 3)
-        {
-            asr::GVector3 n(p[0], p[1], p[2]);
-            m_mesh->set_vertex_normal_pose(
-                i,
-                m_shapeExportStep - 1,
-                asf::safe_normalize(n, Y));
-        }
+    for (size_t i = 0, e = normals.size(); i < e; ++i)
+    {
+        if (normals[i] != m_mesh->get_vertex_normal(i))
+            return false;
     }
+
+    return true;
 }
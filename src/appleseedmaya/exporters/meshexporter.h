@@ -80,6 +80,8 @@ class MeshExporter
 
     MurmurHash hash() const override;
 
+    MemoryUsage memoryUsage() const override;
+
   private:
     MeshExporter(
       const MDagPath&                                   path,
@@ -102,6 +104,12 @@ class MeshExporter
     void exportGeometry(MObject mesh);
     void exportMeshKey(MObject mesh);
 
+    bool isRestPose(
+        const std::vector<renderer::GVector3>&  points,
+        const std::vector<renderer::GVector3>&  normals) const;
+
+    bool exportStandIn(MObject mesh);
+
     AppleseedEntityPtr<renderer::MeshObject>    m_mesh;
     renderer::ParamArray                        m_meshParams;
     bool                                        m_exportUVs;
@@ -110,9 +118,13 @@ class MeshExporter
     std::vector<std::string>                    m_fileNames;
     MIntArray                                   m_perFaceAssignments;
     bool                                        m_isDeforming;
+    bool                                        m_hasMotionKeys;
     size_t                                      m_numMeshKeys;
     size_t                                      m_shapeExportStep;
     AlphaMapExporterPtr                         m_alphaMapExporter;
     MurmurHash                                  m_hash;
+    bool                                        m_standIn;
+    std::string                                 m_standInFileName;
+    MemoryUsage                                 m_memoryUsage;
 };
 
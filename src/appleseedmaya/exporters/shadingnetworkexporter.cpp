@@ -95,16 +95,33 @@ ShadingNetworkExporter::ShadingNetworkExporter(
 
 ShadingNetworkExporter::~ShadingNetworkExporter()
 {
-    if (m_sessionMode == AppleseedSession::ProgressiveRenderSession)
+    if (m_sessionMode == AppleseedSession::ProgressiveRenderSession && m_sharedShaderGroupName.length() == 0)
         m_mainAssembly.shader_groups().remove(m_shaderGroup.get());
 }
 
 MString ShadingNetworkExporter::shaderGroupName() const
 {
+    if (m_sharedShaderGroupName.length() != 0)
+        return m_sharedShaderGroupName;
+
     assert(m_shaderGroup.get());
     return m_shaderGroup->get_name();
 }
 
+const asr::ShaderGroup& ShadingNetworkExporter::shaderGroup() const
+{
+    return *m_shaderGroup;
+}
+
+void ShadingNetworkExporter::shareShaderGroup(const ShadingNetworkExporter& other)
+{
+    assert(m_sharedShaderGroupName.length() == 0);
+
+    // Take back our shader group, so that the renderer does not compile it.
+    m_shaderGroup = m_mainAssembly.shader_groups().remove(m_shaderGroup.get());
+    m_sharedShaderGroupName = other.shaderGroupName();
+}
+
 void ShadingNetworkExporter::createEntities()
 {
     MFnDependencyNode depNodeFn(m_object);
@@ -196,6 +213,17 @@ void ShadingNetworkExporter::flushEntities()
         m_shaderGroup);
 }
 
+MemoryUsage ShadingNetworkExporter::memoryUsage() const
+{
+    MemoryUsage usage;
+
+    // Shared shader groups are counted once, by the exporter that owns them.
+    if (m_shaderGroup.get() && m_sharedShaderGroupName.length() == 0)
+        addShaderGroupMemoryUsage(*m_shaderGroup, usage);
+
+    return usage;
+}
+
 void ShadingNetworkExporter::createShaderNodeExporters(const MObject& node)
 {
     MStatus status;
@@ -34,6 +34,7 @@
 // appleseed-maya headers.
 #include "appleseedmaya/appleseedsession.h"
 #include "appleseedmaya/exporters/shadingnodeexporterfwd.h"
+#include "appleseedmaya/memoryreport.h"
 #include "appleseedmaya/utils.h"
 
 // Build options header.
@@ -68,12 +69,22 @@ class ShadingNetworkExporter
     // Return the name of the appleseed shader group created by this exporter.
     MString shaderGroupName() const;
 
+    // Return the appleseed shader group created by this exporter.
+    const renderer::ShaderGroup& shaderGroup() const;
+
+    // Use the shader group of an exporter of an identical network, and
+    // remove the shader group of this exporter from the assembly.
+    void shareShaderGroup(const ShadingNetworkExporter& other);
+
     // Create appleseed entities.
     void createEntities();
 
     // Flush entities to the renderer.
     void flushEntities();
 
+    // Memory used by the flushed entities.
+    MemoryUsage memoryUsage() const;
+
   private:
     friend class NodeExporterFactory;
 
@@ -92,6 +103,7 @@ class ShadingNetworkExporter
     MPlug                                       m_outputPlug;
     renderer::Assembly&                         m_mainAssembly;
     AppleseedEntityPtr<renderer::ShaderGroup>   m_shaderGroup;
+    MString                                     m_sharedShaderGroupName;
     std::vector<ShadingNodeExporterPtr>         m_nodeExporters;
     ShadingNodeExporterMap                      m_namesToExporters;
 };
@@ -32,6 +32,7 @@
 // appleseed-maya headers.
 #include "appleseedmaya/attributeutils.h"
 #include "appleseedmaya/exporters/exporterfactory.h"
+#include "appleseedmaya/exporters/shadingnodeexportplan.h"
 #include "appleseedmaya/logger.h"
 #include "appleseedmaya/ramputils.h"
 #include "appleseedmaya/shadingnodemetadata.h"
@@ -58,6 +59,7 @@
 
 // Standard headers.
 #include <algorithm>
+#include <cassert>
 #include <sstream>
 #include <vector>
 
@@ -101,7 +103,9 @@ ShadingNodeExporter::ShadingNodeExporter(
     asr::ShaderGroup&                   shaderGroup)
   : m_object(object)
   , m_shaderGroup(shaderGroup)
+  , m_plan(ShadingNodeExportPlan::get(MFnDependencyNode(object).typeName()))
 {
+    assert(m_plan);
 }
 
 void ShadingNodeExporter::createEntities(ShadingNodeExporterMap& exporters)
@@ -109,6 +113,7 @@ void ShadingNodeExporter::createEntities(ShadingNodeExporterMap& exporters)
     MStatus status;
     MFnDependencyNode depNodeFn(m_object);
     const OSLShaderInfo& shaderInfo = getShaderInfo();
+    const std::vector<ShadingNodeExportPlan::Step>& steps = m_plan->steps();
 
     // The fact that we need to specify shaders in depth first
     // order and that Maya allows component connections but OSL
@@ -119,15 +124,16 @@ void ShadingNodeExporter::createEntities(ShadingNodeExporterMap& exporters)
     // - Output adaptor shaders are created as needed.
 
     // Create adaptor shaders and add component connections first.
-    for (size_t i = 0, e = shaderInfo.paramInfo.size(); i < e; ++i)
+    for (size_t i = 0, e = steps.size(); i < e; ++i)
     {
-        const OSLParamInfo& paramInfo = shaderInfo.paramInfo[i];
+        const ShadingNodeExportPlan::Step& step = steps[i];
+        const OSLParamInfo& paramInfo = *step.paramInfo;
 
         // Skip output attributes.
         if (paramInfo.isOutput)
             continue;
 
-        MPlug plug = depNodeFn.findPlug(paramInfo.mayaAttributeName, /*wantNetworkedPlug=*/ false, &status);
+        MPlug plug = m_plan->findPlug(depNodeFn, step, &status);
         if (!status)
             continue;
 
@@ -135,7 +141,7 @@ void ShadingNodeExporter::createEntities(ShadingNodeExporterMap& exporters)
         {
             // If the attribute is a float attribute,
             // check for component connections on the other side.
-            if (paramInfo.paramType == "float")
+            if (step.paramType == ShadingNodeExportPlan::FloatParam)
             {
                 MPlugArray inputConnections;
                 plug.connectedTo(inputConnections, true, false, &status);
@@ -189,7 +195,7 @@ void ShadingNodeExporter::createEntities(ShadingNodeExporterMap& exporters)
 
         if (plug.isCompound() && hasChildrenConnections(plug, true, false))
         {
-            if (paramInfo.paramType == "color")
+            if (step.adaptorStrategy == ShadingNodeExportPlan::ColorAdaptor)
             {
                 createInputFloatCompoundAdaptorShader(
                     paramInfo,
@@ -200,10 +206,7 @@ void ShadingNodeExporter::createEntities(ShadingNodeExporterMap& exporters)
                     g_colorComponentNames,
                     g_componentParamName);
             }
-            else if (
-                paramInfo.paramType == "normal" ||
-                paramInfo.paramType == "point"  ||
-                paramInfo.paramType == "vector")
+            else if (step.adaptorStrategy == ShadingNodeExportPlan::VectorAdaptor)
             {
                 createInputFloatCompoundAdaptorShader(
                     paramInfo,
@@ -214,7 +217,7 @@ void ShadingNodeExporter::createEntities(ShadingNodeExporterMap& exporters)
                     g_vectorComponentNames,
                     g_componentParamName);
             }
-            else if (paramInfo.paramType == "float[2]")
+            else if (step.adaptorStrategy == ShadingNodeExportPlan::UVAdaptor)
             {
                 createInputFloatCompoundAdaptorShader(
                     paramInfo,
@@ -254,15 +257,16 @@ void ShadingNodeExporter::createEntities(ShadingNodeExporterMap& exporters)
         shaderParams);
 
     // Create connections.
-    for (size_t i = 0, e = shaderInfo.paramInfo.size(); i < e; ++i)
+    for (size_t i = 0, e = steps.size(); i < e; ++i)
     {
-        const OSLParamInfo& paramInfo = shaderInfo.paramInfo[i];
+        const ShadingNodeExportPlan::Step& step = steps[i];
+        const OSLParamInfo& paramInfo = *step.paramInfo;
 
         // Skip output attributes.
         if (paramInfo.isOutput)
             continue;
 
-        MPlug plug = depNodeFn.findPlug(paramInfo.mayaAttributeName, /*wantNetworkedPlug=*/ false, &status);
+        MPlug plug = m_plan->findPlug(depNodeFn, step, &status);
         if (!status)
         {
             RENDERER_LOG_WARNING(
@@ -347,12 +351,12 @@ bool ShadingNodeExporter::layerAndParamNameFromPlug(
     {
         MPlug parentPlug = plug.parent();
 
-        const OSLParamInfo* paramInfo = getShaderInfo().findParam(parentPlug);
+        const ShadingNodeExportPlan::Step* step = m_plan->findStep(parentPlug);
 
-        if (!paramInfo)
+        if (!step)
             return false;
 
-        if (paramInfo->paramType == "color")
+        if (step->adaptorStrategy == ShadingNodeExportPlan::ColorAdaptor)
         {
             layerName = "__color2Comps#";
             return createOutputFloatCompoundAdaptorShader(
@@ -363,10 +367,7 @@ bool ShadingNodeExporter::layerAndParamNameFromPlug(
                 layerName,
                 paramName);
         }
-        else if (
-            paramInfo->paramType == "normal" ||
-            paramInfo->paramType == "point"  ||
-            paramInfo->paramType == "vector")
+        else if (step->adaptorStrategy == ShadingNodeExportPlan::VectorAdaptor)
         {
             layerName = "__vector2Comps#";
             return createOutputFloatCompoundAdaptorShader(
@@ -377,7 +378,7 @@ bool ShadingNodeExporter::layerAndParamNameFromPlug(
                 layerName,
                 paramName);
         }
-        else if (paramInfo->paramType == "float[2]")
+        else if (step->adaptorStrategy == ShadingNodeExportPlan::UVAdaptor)
         {
             layerName = "__uv2Comps#";
             return createOutputFloatCompoundAdaptorShader(
@@ -407,10 +408,10 @@ bool ShadingNodeExporter::layerAndParamNameFromPlug(
         return false;
     }
 
-    if (const OSLParamInfo* paramInfo = getShaderInfo().findParam(plug))
+    if (const ShadingNodeExportPlan::Step* step = m_plan->findStep(plug))
     {
         layerName = depNodeFn.name();
-        paramName = paramInfo->paramName;
+        paramName = step->paramInfo->paramName;
         return true;
     }
 
@@ -423,11 +424,14 @@ void ShadingNodeExporter::exportShaderParameters(
 {
     MStatus status;
     MFnDependencyNode depNodeFn(m_object);
+    const std::vector<ShadingNodeExportPlan::Step>& steps = m_plan->steps();
+    assert(&shaderInfo == &m_plan->shaderInfo());
 
-    for (size_t i = 0, e = shaderInfo.paramInfo.size(); i < e; ++i)
+    for (size_t i = 0, e = steps.size(); i < e; ++i)
     {
-        const OSLParamInfo& paramInfo = shaderInfo.paramInfo[i];
-        MPlug plug = depNodeFn.findPlug(paramInfo.mayaAttributeName, /*wantNetworkedPlug=*/ false, &status);
+        const ShadingNodeExportPlan::Step& step = steps[i];
+        const OSLParamInfo& paramInfo = *step.paramInfo;
+        MPlug plug = m_plan->findPlug(depNodeFn, step, &status);
         if (!status)
         {
             RENDERER_LOG_WARNING(
@@ -454,24 +458,23 @@ void ShadingNodeExporter::exportParameterValue(
     const OSLParamInfo&                 paramInfo,
     renderer::ParamArray&               shaderParams) const
 {
-    if (paramInfo.asWidget == "ramp")
-        exportRampValue(plug, paramInfo, shaderParams);
-    else if (paramInfo.asWidget == "ramp_positions")
+    switch (m_plan->step(paramInfo).valueStrategy)
     {
-        // Ramp positions are saved as part of the ramp.
-        return;
-    }
-    else if (paramInfo.asWidget == "ramp_basis")
-    {
-        // Ramp basis is saved as part of the ramp.
-        return;
-    }
-    else
-    {
-        if (paramInfo.isArray)
+        case ShadingNodeExportPlan::ExportRampValue:
+            exportRampValue(plug, paramInfo, shaderParams);
+        break;
+
+        case ShadingNodeExportPlan::ExportArrayValue:
             exportArrayValue(plug, paramInfo, shaderParams);
-        else
+        break;
+
+        case ShadingNodeExportPlan::ExportValue:
             exportValue(plug, paramInfo, shaderParams);
+        break;
+
+        case ShadingNodeExportPlan::SkipValue:
+            // Ramp positions and basis are saved as part of the ramp.
+        break;
     }
 }
 
@@ -484,93 +487,113 @@ void ShadingNodeExporter::exportValue(
         "Exporting shading node attr %s.",
         paramInfo.mayaAttributeName.asChar());
 
+    const ShadingNodeExportPlan::Step& step = m_plan->step(paramInfo);
+
     std::stringstream ss;
 
-    if (paramInfo.paramType == "color")
+    switch (step.paramType)
     {
-        MColor value;
-        if (AttributeUtils::get(plug, value))
-            ss << "color " << value.r << " " << value.g << " " << value.b;
-    }
-    else if (paramInfo.paramType == "float")
-    {
-        if (paramInfo.units == "degrees")
+        case ShadingNodeExportPlan::ColorParam:
         {
-            MAngle value(0.0f, MAngle::kDegrees);
+            MColor value;
             if (AttributeUtils::get(plug, value))
-                ss << "float " << value.asDegrees();
+                ss << "color " << value.r << " " << value.g << " " << value.b;
         }
-        else
+        break;
+
+        case ShadingNodeExportPlan::FloatParam:
         {
-            float value;
-            if (AttributeUtils::get(plug, value))
-                ss << "float " << value;
+            if (step.isDegrees)
+            {
+                MAngle value(0.0f, MAngle::kDegrees);
+                if (AttributeUtils::get(plug, value))
+                    ss << "float " << value.asDegrees();
+            }
+            else
+            {
+                float value;
+                if (AttributeUtils::get(plug, value))
+                    ss << "float " << value;
+            }
         }
-    }
-    else if (paramInfo.paramType == "int")
-    {
-        int value;
-        if (AttributeUtils::get(plug, value))
-            ss << "int " << value;
-        else
+        break;
+
+        case ShadingNodeExportPlan::IntParam:
         {
-            bool boolValue;
-            if (AttributeUtils::get(plug, boolValue))
-                ss << "int " << (boolValue ? "1" : "0"); // ?: has lower precedence than <<
+            int value;
+            if (AttributeUtils::get(plug, value))
+                ss << "int " << value;
+            else
+            {
+                bool boolValue;
+                if (AttributeUtils::get(plug, boolValue))
+                    ss << "int " << (boolValue ? "1" : "0"); // ?: has lower precedence than <<
+            }
         }
-    }
-    else if (paramInfo.paramType == "matrix")
-    {
-        MMatrix matrixValue;
-        if (AttributeUtils::get(plug, matrixValue))
+        break;
+
+        case ShadingNodeExportPlan::MatrixParam:
         {
-            ss << "matrix ";
-            for (int i = 0; i < 4; ++i)
-                for (int j = 0; j < 4; ++j)
-                    ss << matrixValue[i][j] << " ";
+            MMatrix matrixValue;
+            if (AttributeUtils::get(plug, matrixValue))
+            {
+                ss << "matrix ";
+                for (int i = 0; i < 4; ++i)
+                    for (int j = 0; j < 4; ++j)
+                        ss << matrixValue[i][j] << " ";
+            }
         }
-    }
-    else if (paramInfo.paramType == "normal")
-    {
-        MVector value;
-        if (AttributeUtils::get(plug, value))
-            ss << "normal " << value.z << " " << value.y << " " << value.z;
-    }
-    else if (paramInfo.paramType == "point")
-    {
-        MPoint value;
-        if (AttributeUtils::get(plug, value))
-            ss << "point " << value.z << " " << value.y << " " << value.z;
-    }
-    else if (paramInfo.paramType == "string")
-    {
-        if (paramInfo.widget == "popup")
+        break;
+
+        case ShadingNodeExportPlan::NormalParam:
         {
-            MObject attr = plug.attribute();
-            MFnEnumAttribute fnEnumAttr(attr);
-            short shortValue = plug.asShort();
-            MString value = fnEnumAttr.fieldName(shortValue);
-            ss << "string " << value;
+            MVector value;
+            if (AttributeUtils::get(plug, value))
+                ss << "normal " << value.z << " " << value.y << " " << value.z;
         }
-        else
+        break;
+
+        case ShadingNodeExportPlan::PointParam:
         {
-            MString value;
+            MPoint value;
             if (AttributeUtils::get(plug, value))
+                ss << "point " << value.z << " " << value.y << " " << value.z;
+        }
+        break;
+
+        case ShadingNodeExportPlan::StringParam:
+        {
+            if (step.isPopup)
+            {
+                MObject attr = plug.attribute();
+                MFnEnumAttribute fnEnumAttr(attr);
+                short shortValue = plug.asShort();
+                MString value = fnEnumAttr.fieldName(shortValue);
                 ss << "string " << value;
+            }
+            else
+            {
+                MString value;
+                if (AttributeUtils::get(plug, value))
+                    ss << "string " << value;
+            }
         }
-    }
-    else if (paramInfo.paramType == "vector")
-    {
-        MVector value;
-        if (AttributeUtils::get(plug, value))
-            ss << "vector " << value.x << " " << value.y << " " << value.z;
-    }
-    else
-    {
-        RENDERER_LOG_WARNING(
-            "Skipping shading node attr %s of unknown type %s.",
-            paramInfo.mayaAttributeName.asChar(),
-            paramInfo.paramType.asChar());
+        break;
+
+        case ShadingNodeExportPlan::VectorParam:
+        {
+            MVector value;
+            if (AttributeUtils::get(plug, value))
+                ss << "vector " << value.x << " " << value.y << " " << value.z;
+        }
+        break;
+
+        default:
+            RENDERER_LOG_WARNING(
+                "Skipping shading node attr %s of unknown type %s.",
+                paramInfo.mayaAttributeName.asChar(),
+                paramInfo.paramType.asChar());
+        break;
     }
 
     std::string valueAsString = ss.str();
@@ -592,52 +615,57 @@ void ShadingNodeExporter::exportArrayValue(
 
     std::stringstream ss;
 
-    if (strncmp(paramInfo.paramType.asChar(), "float[", 5) == 0)
+    switch (m_plan->step(paramInfo).paramType)
     {
-        assert(plug.isCompound());
-
-        ss << "float[] ";
-        for (unsigned int i = 0, e = plug.numChildren(); i < e; ++i)
+        case ShadingNodeExportPlan::FloatArrayParam:
         {
-            MPlug childPlug = plug.child(i, &status);
-            if (status)
+            assert(plug.isCompound());
+
+            ss << "float[] ";
+            for (unsigned int i = 0, e = plug.numChildren(); i < e; ++i)
             {
-                float value;
-                if (AttributeUtils::get(childPlug, value))
-                    ss << value << " ";
+                MPlug childPlug = plug.child(i, &status);
+                if (status)
+                {
+                    float value;
+                    if (AttributeUtils::get(childPlug, value))
+                        ss << value << " ";
+                    else
+                        valid = false;
+                }
                 else
                     valid = false;
             }
-            else
-                valid = false;
         }
-    }
-    else if (strncmp(paramInfo.paramType.asChar(), "int[", 4) == 0)
-    {
-        assert(plug.isCompound());
+        break;
 
-        ss << "int[] ";
-        for (unsigned int i = 0, e = plug.numChildren(); i < e; ++i)
+        case ShadingNodeExportPlan::IntArrayParam:
         {
-            MPlug childPlug = plug.child(i, &status);
-            if (status)
+            assert(plug.isCompound());
+
+            ss << "int[] ";
+            for (unsigned int i = 0, e = plug.numChildren(); i < e; ++i)
             {
-                int value;
-                if (AttributeUtils::get(childPlug, value))
-                    ss << value << " ";
+                MPlug childPlug = plug.child(i, &status);
+                if (status)
+                {
+                    int value;
+                    if (AttributeUtils::get(childPlug, value))
+                        ss << value << " ";
+                    else
+                        valid = false;
+                }
                 else
                     valid = false;
             }
-            else
-                valid = false;
         }
-    }
-    else
-    {
-        RENDERER_LOG_WARNING(
-            "Skipping shading node attr %s of type %s.",
-            paramInfo.mayaAttributeName.asChar(),
-            paramInfo.paramType.asChar());
+        break;
+
+        default:
+            RENDERER_LOG_WARNING(
+                "Skipping shading node attr %s of type %s.",
+                paramInfo.mayaAttributeName.asChar(),
+                paramInfo.paramType.asChar());
         return;
     }
 
@@ -700,24 +728,29 @@ void ShadingNodeExporter::exportRampValue(
     std::string positions;
     // std::string basis;
 
-    if (paramInfo.paramType == "color[]")
-    {
-        std::vector<RampEntry<MColor>> entries;
-        getRampValues(ramp, entries);
-        serializeRamp(entries, values, positions);
-    }
-    else if (paramInfo.paramType == "float[]")
-    {
-        std::vector<RampEntry<float>> entries;
-        getRampValues(ramp, entries);
-        serializeRamp(entries, values, positions);
-    }
-    else
+    switch (m_plan->step(paramInfo).paramType)
     {
-        RENDERER_LOG_WARNING(
-            "Skipping shading node attr %s of unknown type %s ramp.",
-            paramInfo.mayaAttributeName.asChar(),
-            paramInfo.paramType.asChar());
+        case ShadingNodeExportPlan::ColorRampParam:
+        {
+            std::vector<RampEntry<MColor>> entries;
+            getRampValues(ramp, entries);
+            serializeRamp(entries, values, positions);
+        }
+        break;
+
+        case ShadingNodeExportPlan::FloatRampParam:
+        {
+            std::vector<RampEntry<float>> entries;
+            getRampValues(ramp, entries);
+            serializeRamp(entries, values, positions);
+        }
+        break;
+
+        default:
+            RENDERER_LOG_WARNING(
+                "Skipping shading node attr %s of unknown type %s ramp.",
+                paramInfo.mayaAttributeName.asChar(),
+                paramInfo.paramType.asChar());
         return;
     }
 
@@ -798,11 +831,7 @@ bool ShadingNodeExporter::hasElementConnections(
 
 const OSLShaderInfo& ShadingNodeExporter::getShaderInfo() const
 {
-    MFnDependencyNode depNodeFn(m_object);
-    const OSLShaderInfo* shaderInfo = ShadingNodeRegistry::getShaderInfo(depNodeFn.typeName());
-    assert(shaderInfo);
-
-    return *shaderInfo;
+    return m_plan->shaderInfo();
 }
 
 ShadingNodeExporter* ShadingNodeExporter::findExporterForNode(
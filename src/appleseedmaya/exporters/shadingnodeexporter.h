@@ -51,6 +51,7 @@
 // Forward declarations.
 class OSLParamInfo;
 class OSLShaderInfo;
+class ShadingNodeExportPlan;
 namespace renderer { class ParamArray; }
 namespace renderer { class ShaderGroup; }
 
@@ -148,5 +149,6 @@ class ShadingNodeExporter
 
     MObject                         m_object;
     renderer::ShaderGroup&          m_shaderGroup;
+    const ShadingNodeExportPlan*    m_plan;
 };
 
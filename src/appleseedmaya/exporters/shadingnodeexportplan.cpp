@@ -0,0 +1,243 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "shadingnodeexportplan.h"
+
+// appleseed-maya headers.
+#include "appleseedmaya/logger.h"
+#include "appleseedmaya/shadingnodemetadata.h"
+#include "appleseedmaya/shadingnoderegistry.h"
+
+// Maya headers.
+#include "appleseedmaya/_beginmayaheaders.h"
+#include <maya/MNodeClass.h>
+#include "appleseedmaya/_endmayaheaders.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <memory>
+
+namespace
+{
+    typedef std::map<
+        MString,
+        std::unique_ptr<ShadingNodeExportPlan>,
+        MStringCompareLess
+        > ExportPlanMap;
+
+    ExportPlanMap gExportPlans;
+
+    ShadingNodeExportPlan::ParamType paramTypeFromInfo(const OSLParamInfo& paramInfo)
+    {
+        const MString& t = paramInfo.paramType;
+
+        if (paramInfo.asWidget == "ramp")
+        {
+            if (t == "color[]")
+                return ShadingNodeExportPlan::ColorRampParam;
+
+            if (t == "float[]")
+                return ShadingNodeExportPlan::FloatRampParam;
+
+            return ShadingNodeExportPlan::UnknownParam;
+        }
+
+        if (paramInfo.isArray)
+        {
+            if (strncmp(t.asChar(), "float[", 5) == 0)
+                return ShadingNodeExportPlan::FloatArrayParam;
+
+            if (strncmp(t.asChar(), "int[", 4) == 0)
+                return ShadingNodeExportPlan::IntArrayParam;
+
+            return ShadingNodeExportPlan::UnknownParam;
+        }
+
+        if (t == "color")
+            return ShadingNodeExportPlan::ColorParam;
+        if (t == "float")
+            return ShadingNodeExportPlan::FloatParam;
+        if (t == "int")
+            return ShadingNodeExportPlan::IntParam;
+        if (t == "matrix")
+            return ShadingNodeExportPlan::MatrixParam;
+        if (t == "normal")
+            return ShadingNodeExportPlan::NormalParam;
+        if (t == "point")
+            return ShadingNodeExportPlan::PointParam;
+        if (t == "string")
+            return ShadingNodeExportPlan::StringParam;
+        if (t == "vector")
+            return ShadingNodeExportPlan::VectorParam;
+
+        return ShadingNodeExportPlan::UnknownParam;
+    }
+
+    ShadingNodeExportPlan::ValueStrategy valueStrategyFromInfo(const OSLParamInfo& paramInfo)
+    {
+        if (paramInfo.asWidget == "ramp")
+            return ShadingNodeExportPlan::ExportRampValue;
+
+        // Ramp positions and basis are saved as part of the ramp.
+        if (paramInfo.asWidget == "ramp_positions" || paramInfo.asWidget == "ramp_basis")
+            return ShadingNodeExportPlan::SkipValue;
+
+        if (paramInfo.isArray)
+            return ShadingNodeExportPlan::ExportArrayValue;
+
+        return ShadingNodeExportPlan::ExportValue;
+    }
+
+    ShadingNodeExportPlan::AdaptorStrategy adaptorStrategyFromInfo(const OSLParamInfo& paramInfo)
+    {
+        const MString& t = paramInfo.paramType;
+
+        if (t == "color")
+            return ShadingNodeExportPlan::ColorAdaptor;
+
+        if (t == "normal" || t == "point" || t == "vector")
+            return ShadingNodeExportPlan::VectorAdaptor;
+
+        if (t == "float[2]")
+            return ShadingNodeExportPlan::UVAdaptor;
+
+        return ShadingNodeExportPlan::NoAdaptor;
+    }
+}
+
+const ShadingNodeExportPlan* ShadingNodeExportPlan::get(const MString& nodeTypeName)
+{
+    auto it = gExportPlans.find(nodeTypeName);
+
+    if (it != gExportPlans.end())
+        return it->second.get();
+
+    const OSLShaderInfo* shaderInfo = ShadingNodeRegistry::getShaderInfo(nodeTypeName);
+    if (!shaderInfo)
+        return nullptr;
+
+    std::unique_ptr<ShadingNodeExportPlan> plan(new ShadingNodeExportPlan(nodeTypeName, *shaderInfo));
+    const ShadingNodeExportPlan* result = plan.get();
+    gExportPlans[nodeTypeName] = std::move(plan);
+    return result;
+}
+
+void ShadingNodeExportPlan::clear()
+{
+    gExportPlans.clear();
+}
+
+ShadingNodeExportPlan::ShadingNodeExportPlan(
+    const MString&              nodeTypeName,
+    const OSLShaderInfo&        shaderInfo)
+  : m_shaderInfo(shaderInfo)
+  , m_hasUnresolvedAttributes(false)
+{
+    RENDERER_LOG_DEBUG(
+        "Compiling export plan for shading node type %s.",
+        nodeTypeName.asChar());
+
+    MNodeClass nodeClass(nodeTypeName);
+
+    m_steps.resize(shaderInfo.paramInfo.size());
+    for (size_t i = 0, e = shaderInfo.paramInfo.size(); i < e; ++i)
+    {
+        const OSLParamInfo& paramInfo = shaderInfo.paramInfo[i];
+
+        Step& s = m_steps[i];
+        s.paramInfo = &paramInfo;
+        s.paramType = paramTypeFromInfo(paramInfo);
+        s.valueStrategy = valueStrategyFromInfo(paramInfo);
+        s.adaptorStrategy = adaptorStrategyFromInfo(paramInfo);
+        s.isDegrees = paramInfo.units == "degrees";
+        s.isPopup = paramInfo.widget == "popup";
+
+        // Dynamic attributes are not known by the node class;
+        // plugs for them are found by name at export time.
+        MStatus status;
+        s.attribute = nodeClass.attribute(paramInfo.mayaAttributeName, &status);
+        if (!status)
+        {
+            s.attribute = MObject::kNullObj;
+            m_hasUnresolvedAttributes = true;
+        }
+    }
+}
+
+const OSLShaderInfo& ShadingNodeExportPlan::shaderInfo() const
+{
+    return m_shaderInfo;
+}
+
+const std::vector<ShadingNodeExportPlan::Step>& ShadingNodeExportPlan::steps() const
+{
+    return m_steps;
+}
+
+const ShadingNodeExportPlan::Step& ShadingNodeExportPlan::step(const OSLParamInfo& paramInfo) const
+{
+    // Steps are stored in the same order as the shader info parameters.
+    assert(!m_shaderInfo.paramInfo.empty());
+    assert(&paramInfo >= &m_shaderInfo.paramInfo.front());
+    assert(&paramInfo <= &m_shaderInfo.paramInfo.back());
+
+    return m_steps[&paramInfo - &m_shaderInfo.paramInfo.front()];
+}
+
+const ShadingNodeExportPlan::Step* ShadingNodeExportPlan::findStep(const MPlug& plug) const
+{
+    const MObject attr = plug.attribute();
+
+    for (size_t i = 0, e = m_steps.size(); i < e; ++i)
+    {
+        if (!m_steps[i].attribute.isNull() && m_steps[i].attribute == attr)
+            return &m_steps[i];
+    }
+
+    if (m_hasUnresolvedAttributes)
+    {
+        if (const OSLParamInfo* paramInfo = m_shaderInfo.findParam(plug))
+            return &step(*paramInfo);
+    }
+
+    return nullptr;
+}
+
+MPlug ShadingNodeExportPlan::findPlug(
+    const MFnDependencyNode&    depNodeFn,
+    const Step&                 step,
+    MStatus*                    status) const
+{
+    if (!step.attribute.isNull())
+        return depNodeFn.findPlug(step.attribute, /*wantNetworkedPlug=*/ false, status);
+
+    return depNodeFn.findPlug(step.paramInfo->mayaAttributeName, /*wantNetworkedPlug=*/ false, status);
+}
@@ -0,0 +1,144 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed-maya headers.
+#include "appleseedmaya/utils.h"
+
+// Build options header.
+#include "foundation/core/buildoptions.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Maya headers.
+#include "appleseedmaya/_beginmayaheaders.h"
+#include <maya/MFnDependencyNode.h>
+#include <maya/MObject.h>
+#include <maya/MPlug.h>
+#include <maya/MStatus.h>
+#include <maya/MString.h>
+#include "appleseedmaya/_endmayaheaders.h"
+
+// Standard headers.
+#include <vector>
+
+// Forward declarations.
+class OSLParamInfo;
+class OSLShaderInfo;
+
+//
+// ShadingNodeExportPlan.
+//
+//  Per shader type data precomputed from an OSLShaderInfo,
+//  so that exporting a shading node does not need to look up
+//  attributes by name and compare parameter type strings.
+//
+
+class ShadingNodeExportPlan
+  : public foundation::NonCopyable
+{
+  public:
+    enum ParamType
+    {
+        UnknownParam = 0,
+        ColorParam,
+        FloatParam,
+        IntParam,
+        MatrixParam,
+        NormalParam,
+        PointParam,
+        StringParam,
+        VectorParam,
+        FloatArrayParam,
+        IntArrayParam,
+        ColorRampParam,
+        FloatRampParam
+    };
+
+    enum ValueStrategy
+    {
+        ExportValue = 0,
+        ExportArrayValue,
+        ExportRampValue,
+        SkipValue
+    };
+
+    enum AdaptorStrategy
+    {
+        NoAdaptor = 0,
+        ColorAdaptor,
+        VectorAdaptor,
+        UVAdaptor
+    };
+
+    struct Step
+    {
+        const OSLParamInfo* paramInfo;
+        MObject             attribute;
+        ParamType           paramType;
+        ValueStrategy       valueStrategy;
+        AdaptorStrategy     adaptorStrategy;
+        bool                isDegrees;
+        bool                isPopup;
+    };
+
+    // Return the plan for a shading node type, compiling it if needed.
+    // Returns a nullptr if the node type is not a registered shading node.
+    static const ShadingNodeExportPlan* get(const MString& nodeTypeName);
+
+    // Release all cached plans.
+    static void clear();
+
+    const OSLShaderInfo& shaderInfo() const;
+
+    // Steps, in the same order as the shader info parameters.
+    const std::vector<Step>& steps() const;
+
+    // Return the step for a parameter of this plan's shader.
+    const Step& step(const OSLParamInfo& paramInfo) const;
+
+    // Return the step for an attribute of a node of this type or a nullptr.
+    const Step* findStep(const MPlug& plug) const;
+
+    // Return the plug for a step on a node of this type.
+    MPlug findPlug(
+        const MFnDependencyNode&    depNodeFn,
+        const Step&                 step,
+        MStatus*                    status) const;
+
+  private:
+    ShadingNodeExportPlan(
+        const MString&              nodeTypeName,
+        const OSLShaderInfo&        shaderInfo);
+
+    const OSLShaderInfo&    m_shaderInfo;
+    std::vector<Step>       m_steps;
+    bool                    m_hasUnresolvedAttributes;
+};
@@ -89,8 +89,9 @@ asf::AABB3d ShapeExporter::boundingBox() const
 
 void ShapeExporter::exportTransformMotionStep(float time)
 {
-    asf::Matrix4d m = convert(dagPath().inclusiveMatrix());
-    asf::Matrix4d invM = convert(dagPath().inclusiveMatrixInverse());
+    const MMatrix worldM = worldMatrix();
+    asf::Matrix4d m = convert(worldM);
+    asf::Matrix4d invM = convert(worldM.inverse());
     asf::Transformd xform(m, invM);
     m_transformSequence.set_transform(time, xform);
 }
@@ -104,29 +105,57 @@ void ShapeExporter::flushEntities()
     if (sessionMode() == AppleseedSession::ProgressiveRenderSession || needsAssembly)
     {
         const MString assemblyName = appleseedName() + MString("_assembly");
-        m_objectAssembly.reset(
+        insertObjectAssembly(
             asr::AssemblyFactory().create(assemblyName.asChar(), asr::ParamArray()));
+    }
+}
 
-        mainAssembly().assemblies().insert(m_objectAssembly.release());
-        const MString assemblyInstanceName = assemblyName + MString("_instance");
+void ShapeExporter::insertObjectAssembly(asf::auto_release_ptr<asr::Assembly> assembly)
+{
+    const MString assemblyName = assembly->get_name();
+    m_objectAssembly.reset(assembly);
+    mainAssembly().assemblies().insert(m_objectAssembly.release());
 
-        asr::ParamArray params;
-        addVisibilityAttributesToParams(params);
-        m_objectAssemblyInstance.reset(
-            asr::AssemblyInstanceFactory::create(
-                assemblyInstanceName.asChar(),
-                params,
-                assemblyName.asChar()));
-
-        m_objectAssemblyInstance->transform_sequence() = m_transformSequence;
-        mainAssembly().assembly_instances().insert(m_objectAssemblyInstance.release());
-    }
+    const MString assemblyInstanceName = assemblyName + MString("_instance");
+
+    asr::ParamArray params;
+    addVisibilityAttributesToParams(params);
+    m_objectAssemblyInstance.reset(
+        asr::AssemblyInstanceFactory::create(
+            assemblyInstanceName.asChar(),
+            params,
+            assemblyName.asChar()));
+
+    m_objectAssemblyInstance->transform_sequence() = m_transformSequence;
+    mainAssembly().assembly_instances().insert(m_objectAssemblyInstance.release());
 }
 
 void ShapeExporter::shapeAttributesToParams(renderer::ParamArray& params)
 {
 }
 
+void ShapeExporter::objectInstanceAttributesToParams(renderer::ParamArray& params) const
+{
+    MString sssSet;
+    if (AttributeUtils::get(node(), "asSubsurfaceSet", sssSet))
+    {
+        if (sssSet.length() != 0)
+            params.insert_path("sss_set_id", sssSet.asChar());
+    }
+
+    int mediumPriority = 0;
+    if (AttributeUtils::get(node(), "asMediumPriority", mediumPriority))
+        params.insert("medium_priority", mediumPriority);
+
+    bool isPhotonTarget = false;
+    if (AttributeUtils::get(node(), "asIsPhotonTarget", isPhotonTarget))
+        params.insert("photon_target", isPhotonTarget);
+
+    float shadowTerminatorCorrection = 0.0f;
+    if (AttributeUtils::get(node(), "asShadowTerminatorCorrection", shadowTerminatorCorrection))
+        params.insert("shadow_terminator_correction", shadowTerminatorCorrection);
+}
+
 void ShapeExporter::createObjectInstance(const MString& objectName)
 {
     asr::Assembly* objectAssembly = &mainAssembly();
@@ -147,26 +176,7 @@ void ShapeExporter::createObjectInstance(const MString& objectName)
     const MString objectInstanceName = appleseedName() + MString("_instance");
 
     // Get object instance params.
-    {
-        MString sssSet;
-        if (AttributeUtils::get(node(), "asSubsurfaceSet", sssSet))
-        {
-            if (sssSet.length() != 0)
-                params.insert_path("sss_set_id", sssSet.asChar());
-        }
-
-        int mediumPriority = 0;
-        if (AttributeUtils::get(node(), "asMediumPriority", mediumPriority))
-            params.insert("medium_priority", mediumPriority);
-
-        bool isPhotonTarget = false;
-        if (AttributeUtils::get(node(), "asIsPhotonTarget", isPhotonTarget))
-            params.insert("photon_target", isPhotonTarget);
-
-        float shadowTerminatorCorrection = 0.0f;
-        if (AttributeUtils::get(node(), "asShadowTerminatorCorrection", shadowTerminatorCorrection))
-            params.insert("shadow_terminator_correction", shadowTerminatorCorrection);
-    }
+    objectInstanceAttributesToParams(params);
 
     m_objectInstance.reset(
         asr::ObjectInstanceFactory::create(
@@ -74,6 +74,11 @@ class ShapeExporter
 
     void shapeAttributesToParams(renderer::ParamArray& params);
 
+    void objectInstanceAttributesToParams(renderer::ParamArray& params) const;
+
+    // Insert an assembly for this object into the main assembly, and instance it.
+    void insertObjectAssembly(foundation::auto_release_ptr<renderer::Assembly> assembly);
+
     void createObjectInstance(const MString& objectName);
 
     renderer::TransformSequence                     m_transformSequence;
@@ -32,10 +32,15 @@
 // appleseed-maya headers.
 #include "appleseedmaya/attributeutils.h"
 #include "appleseedmaya/exporters/exporterfactory.h"
+#include "appleseedmaya/murmurhash.h"
 
 // appleseed.renderer headers.
+#include "renderer/api/log.h"
 #include "renderer/api/scene.h"
 
+// appleseed.foundation headers.
+#include "foundation/string/string.h"
+
 // Maya headers.
 #include "appleseedmaya/_beginmayaheaders.h"
 #include <maya/MAnimControl.h>
@@ -45,12 +50,87 @@
 #include <maya/MTime.h>
 #include "appleseedmaya/_endmayaheaders.h"
 
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
 // Standard headers.
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace asf = foundation;
 namespace asr = renderer;
+namespace bfs = boost::filesystem;
+
+namespace
+{
+
+std::time_t lastWriteTime(const std::string& path)
+{
+    boost::system::error_code ec;
+    const std::time_t t = bfs::last_write_time(bfs::path(path), ec);
+    return ec ? 0 : t;
+}
+
+// Append the names, sizes and modification times of all the files below a directory.
+void appendDirectoryContents(const bfs::path& dir, MurmurHash& hash)
+{
+    std::vector<std::string> entries;
+
+    boost::system::error_code ec;
+    for (bfs::recursive_directory_iterator it(dir, ec), e; !ec && it != e; it.increment(ec))
+    {
+        if (!bfs::is_regular_file(it->status()))
+            continue;
+
+        const std::string path = it->path().string();
+        const std::uintmax_t size = bfs::file_size(it->path(), ec);
+        entries.push_back(
+            asf::format("{0} {1} {2}", path, ec ? 0 : size, lastWriteTime(path)));
+        ec.clear();
+    }
+
+    // Directory iteration order is unspecified.
+    std::sort(entries.begin(), entries.end());
+
+    hash.append(entries.size());
+    for (const std::string& entry : entries)
+        hash.append(entry);
+}
+
+// Data directories of an XGen description: paint maps, region maps,
+// expression maps and other files referenced by the description.
+std::vector<bfs::path> descriptionDataDirectories(
+    const MObject&  palette,
+    const MString&  descriptionName)
+{
+    std::vector<bfs::path> dirs;
+
+    MString dataPath;
+    AttributeUtils::get(palette, "xgDataPath", dataPath);
+
+    MString projectPath;
+    MGlobal::executeCommand("workspace -q -rd", projectPath);
+
+    std::vector<std::string> paths;
+    asf::split(dataPath.asChar(), ";", paths);
+
+    for (std::string& path : paths)
+    {
+        path = asf::replace(path, "${PROJECT}", projectPath.asChar());
+        if (!path.empty())
+            dirs.push_back(bfs::path(path) / descriptionName.asChar());
+    }
+
+    return dirs;
+}
+
+}
 
 void XGenExporter::registerExporter()
 {
@@ -183,9 +263,11 @@ void XGenExporter::createEntities(
         descriptionPath.fullPathName().asChar() + paletteName.length() + 2);
 
     // Build the XGen arguments string.
+    const double currentFrame = MAnimControl::currentTime().value();
+
     std::string xgen_args;
     xgen_args  = "-debug 1 -warning 1 -stats 1 ";
-    xgen_args += asf::format(" -frame {0}", MAnimControl::currentTime().value());
+    xgen_args += asf::format(" -frame {0}", currentFrame);
     xgen_args += asf::format(" -fps {0}", getFps());
     xgen_args += asf::format(" -file {0}{1}__{2}.xgen", scenePath.asChar(), sceneName.asChar(), paletteName.asChar());
     xgen_args += asf::format(" -palette {0}", paletteName.asChar());
@@ -194,6 +276,70 @@ void XGenExporter::createEntities(
     xgen_args += asf::format(" -description {0}", descriptionName.asChar());
     xgen_args += asf::format(" -world {0};0;0;0;0;{0};0;0;0;0;{0};0;0;0;0;1", getUnitConversionFactor());
 
+    // Optional on disk cache of the expanded primitives, shared between renders.
+    // Entries are invalidated when the XGen arguments, the XGen files or the
+    // files in the description data directories change. Files referenced by
+    // absolute paths outside of the collection data path are not tracked,
+    // and require clearing the cache directory when they change.
+    std::string cacheDir;
+    MurmurHash cacheKey;
+    if (const char* cachePath = getenv("APPLESEED_MAYA_XGEN_CACHE_PATH"))
+    {
+        boost::system::error_code ec;
+        bfs::create_directories(bfs::path(cachePath), ec);
+
+        if (bfs::is_directory(bfs::path(cachePath), ec))
+        {
+            cacheDir = cachePath;
+            cacheKey.append(xgen_args);
+            cacheKey.append(lastWriteTime(
+                asf::format("{0}{1}__{2}.xgen", scenePath.asChar(), sceneName.asChar(), paletteName.asChar())));
+            cacheKey.append(lastWriteTime(
+                asf::format("{0}{1}__{2}.abc", scenePath.asChar(), sceneName.asChar(), paletteName.asChar())));
+
+            // Maps painted or baked by the user are found in the description data directories.
+            for (const bfs::path& dir : descriptionDataDirectories(palettePath.node(), descriptionName))
+                appendDirectoryContents(dir, cacheKey);
+        }
+        else
+        {
+            RENDERER_LOG_WARNING(
+                "appleseedMaya: XGen cache directory %s is not valid, disabling XGen cache.",
+                cachePath);
+        }
+    }
+
+    // Deformation motion blur sample times, relative to the current frame.
+    // XGen generates all the motion samples of a patch in a single pass.
+    std::string shutter;
+    if (motionBlurSampleTimes.m_deformTimes.size() > 1)
+    {
+        for (const float time : motionBlurSampleTimes.m_deformTimes)
+        {
+            if (!shutter.empty())
+                shutter += " ";
+
+            shutter += asf::to_string(time - currentFrame);
+        }
+    }
+
+    // Distance based density falloff, applied by the procedural.
+    bool lodEnable = false;
+    AttributeUtils::get(node(), "asLodEnable", lodEnable);
+
+    float falloffStart = 10.0f;
+    float falloffEnd = 100.0f;
+    float minDensity = 0.1f;
+    bool widthCompensation = true;
+
+    if (lodEnable)
+    {
+        AttributeUtils::get(node(), "asDensityFalloffStart", falloffStart);
+        AttributeUtils::get(node(), "asDensityFalloffEnd", falloffEnd);
+        AttributeUtils::get(node(), "asMinDensity", minDensity);
+        AttributeUtils::get(node(), "asWidthCompensation", widthCompensation);
+    }
+
     for (unsigned int i = 0, e = descriptionPath.childCount(); i < e; ++i)
     {
         MDagPath childDagPath;
@@ -219,6 +365,23 @@ void XGenExporter::createEntities(
             params.insert_path(
                 "parameters.xgen_args", asf::format(xgen_args, patchName.asChar()).c_str());
 
+            if (!shutter.empty())
+                params.insert_path("parameters.shutter", shutter.c_str());
+
+            if (lodEnable)
+            {
+                params.insert_path(
+                    "parameters.density_falloff",
+                    asf::format("{0} {1} {2}", falloffStart, falloffEnd, minDensity).c_str());
+                params.insert_path("parameters.width_compensation", widthCompensation);
+            }
+
+            if (!cacheDir.empty())
+            {
+                params.insert_path("parameters.cache_dir", cacheDir.c_str());
+                params.insert_path("parameters.cache_key", cacheKey.toString().c_str());
+            }
+
             const asr::AssemblyFactoryRegistrar& assemblyFactories =
                 project().get_factory_registrar<asr::Assembly>();
 
@@ -244,8 +407,9 @@ void XGenExporter::createEntities(
 
 void XGenExporter::exportTransformMotionStep(float time)
 {
-    asf::Matrix4d m = convert(dagPath().inclusiveMatrix());
-    asf::Matrix4d invM = convert(dagPath().inclusiveMatrixInverse());
+    const MMatrix worldM = worldMatrix();
+    asf::Matrix4d m = convert(worldM);
+    asf::Matrix4d invM = convert(worldM.inverse());
     asf::Transformd xform(m, invM);
     m_transformSequence.set_transform(time, xform);
 }
@@ -0,0 +1,409 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "exportprofiler.h"
+
+// appleseed-maya headers.
+#include "appleseedmaya/utils.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/frame.h"
+#include "renderer/api/log.h"
+
+// Standard headers.
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+namespace asr = renderer;
+
+namespace
+{
+    class ProfiledTileCallback
+      : public asr::TileCallbackBase
+    {
+      public:
+        ProfiledTileCallback(
+            ProfiledTileCallbackFactory&    factory,
+            asr::ITileCallback*             callback)
+          : m_factory(factory)
+          , m_callback(callback)
+        {
+        }
+
+        void release() override
+        {
+            if (m_callback)
+                m_callback->release();
+
+            delete this;
+        }
+
+        void on_tiled_frame_begin(const asr::Frame* frame) override
+        {
+            if (m_callback)
+                m_callback->on_tiled_frame_begin(frame);
+        }
+
+        void on_tiled_frame_end(const asr::Frame* frame) override
+        {
+            if (m_callback)
+                m_callback->on_tiled_frame_end(frame);
+        }
+
+        void on_tile_begin(
+            const asr::Frame*       frame,
+            const size_t            tile_x,
+            const size_t            tile_y,
+            const size_t            thread_index,
+            const size_t            thread_count) override
+        {
+            if (m_callback)
+                m_callback->on_tile_begin(frame, tile_x, tile_y, thread_index, thread_count);
+        }
+
+        void on_tile_end(
+            const asr::Frame*       frame,
+            const size_t            tile_x,
+            const size_t            tile_y) override
+        {
+            if (m_callback)
+                m_callback->on_tile_end(frame, tile_x, tile_y);
+
+            m_factory.pixelsRendered();
+        }
+
+        void on_progressive_frame_update(
+            const asr::Frame&       frame,
+            const double            time,
+            const std::uint64_t     samples,
+            const double            samples_per_pixel,
+            const std::uint64_t     samples_per_second) override
+        {
+            if (m_callback)
+            {
+                m_callback->on_progressive_frame_update(
+                    frame,
+                    time,
+                    samples,
+                    samples_per_pixel,
+                    samples_per_second);
+            }
+
+            m_factory.pixelsRendered();
+        }
+
+      private:
+        ProfiledTileCallbackFactory&    m_factory;
+        asr::ITileCallback*             m_callback;
+    };
+
+    struct Stats
+    {
+        Stats()
+          : m_count(0)
+          , m_total(0)
+          , m_max(0)
+        {
+        }
+
+        void add(const std::uint64_t duration)
+        {
+            ++m_count;
+            m_total += duration;
+            m_max = std::max(m_max, duration);
+        }
+
+        std::size_t     m_count;
+        std::uint64_t   m_total;
+        std::uint64_t   m_max;
+    };
+
+    typedef std::pair<std::string, Stats> NamedStats;
+
+    std::vector<NamedStats> sortByTotalTime(const std::map<std::string, Stats>& stats)
+    {
+        std::vector<NamedStats> result(stats.begin(), stats.end());
+        std::sort(
+            result.begin(),
+            result.end(),
+            [](const NamedStats& a, const NamedStats& b)
+            {
+                return a.second.m_total > b.second.m_total;
+            });
+        return result;
+    }
+
+    void logStats(const char* title, const std::vector<NamedStats>& stats, const std::size_t maxRows)
+    {
+        RENDERER_LOG_INFO("%s:", title);
+        RENDERER_LOG_INFO("  %-48s %10s %12s %12s", "", "count", "total (ms)", "max (ms)");
+
+        for (std::size_t i = 0, e = std::min(stats.size(), maxRows); i < e; ++i)
+        {
+            RENDERER_LOG_INFO(
+                "  %-48s %10zu %12.3f %12.3f",
+                stats[i].first.c_str(),
+                stats[i].second.m_count,
+                static_cast<double>(stats[i].second.m_total) / 1000.0,
+                static_cast<double>(stats[i].second.m_max) / 1000.0);
+        }
+    }
+
+    const std::size_t MaxSlowestNodes = 20;
+}
+
+//
+// ExportProfiler class implementation.
+//
+
+ExportProfiler::ExportProfiler()
+  : m_enabled(false)
+  , m_origin(std::chrono::steady_clock::now())
+{
+}
+
+bool ExportProfiler::isEnabled() const
+{
+    return m_enabled;
+}
+
+void ExportProfiler::setEnabled(const bool enabled)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (enabled && !m_enabled)
+    {
+        m_origin = std::chrono::steady_clock::now();
+        m_events.clear();
+        m_lanes.clear();
+        m_laneNames.clear();
+    }
+
+    m_enabled = enabled;
+}
+
+void ExportProfiler::setThreadName(const char* name)
+{
+    if (!m_enabled)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_laneNames[laneForCurrentThread()] = name;
+}
+
+std::uint64_t ExportProfiler::now() const
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_origin).count());
+}
+
+void ExportProfiler::addEvent(
+    const char*             phase,
+    const std::string&      nodeType,
+    const std::string&      nodeName,
+    const std::uint64_t     start,
+    const std::uint64_t     end)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Event event;
+    event.m_phase = phase;
+    event.m_nodeType = nodeType;
+    event.m_nodeName = nodeName;
+    event.m_start = start;
+    event.m_duration = end - start;
+    event.m_lane = laneForCurrentThread();
+    m_events.push_back(event);
+}
+
+bool ExportProfiler::writeChromeTrace(const std::string& filename) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::ofstream file(filename.c_str());
+
+    if (!file.is_open())
+    {
+        RENDERER_LOG_ERROR("Could not open export trace file %s", filename.c_str());
+        return false;
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    // Name the lanes.
+    file << "{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"appleseed-maya\"}}";
+
+    for (std::size_t i = 0, e = m_laneNames.size(); i < e; ++i)
+    {
+        file << ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+        writeJSONString(file, m_laneNames[i]);
+        file << "}}";
+    }
+
+    for (const Event& event : m_events)
+    {
+        file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << event.m_lane;
+        file << ",\"ts\":" << event.m_start << ",\"dur\":" << event.m_duration;
+
+        if (event.m_nodeName.empty())
+        {
+            file << ",\"cat\":\"phase\",\"name\":";
+            writeJSONString(file, event.m_phase);
+        }
+        else
+        {
+            file << ",\"cat\":";
+            writeJSONString(file, event.m_nodeType);
+            file << ",\"name\":";
+            writeJSONString(file, event.m_nodeName);
+            file << ",\"args\":{\"phase\":";
+            writeJSONString(file, event.m_phase);
+            file << ",\"type\":";
+            writeJSONString(file, event.m_nodeType);
+            file << "}";
+        }
+
+        file << "}";
+    }
+
+    file << "\n]}\n";
+
+    if (!file)
+    {
+        RENDERER_LOG_ERROR("Could not write export trace file %s", filename.c_str());
+        return false;
+    }
+
+    RENDERER_LOG_INFO("Wrote export trace to %s", filename.c_str());
+    return true;
+}
+
+void ExportProfiler::logSummary() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::map<std::string, Stats> phaseStats;
+    std::map<std::string, Stats> nodeTypeStats;
+    std::map<std::string, Stats> nodeStats;
+
+    for (const Event& event : m_events)
+    {
+        if (event.m_nodeName.empty())
+            phaseStats[event.m_phase].add(event.m_duration);
+        else
+        {
+            nodeTypeStats[std::string(event.m_phase) + " / " + event.m_nodeType].add(event.m_duration);
+            nodeStats[event.m_nodeName].add(event.m_duration);
+        }
+    }
+
+    RENDERER_LOG_INFO("Export profile:");
+    logStats("Phases", sortByTotalTime(phaseStats), phaseStats.size());
+    logStats("Phases per node type", sortByTotalTime(nodeTypeStats), nodeTypeStats.size());
+    logStats("Slowest nodes", sortByTotalTime(nodeStats), MaxSlowestNodes);
+}
+
+std::uint32_t ExportProfiler::laneForCurrentThread()
+{
+    const std::thread::id id = std::this_thread::get_id();
+    auto it = m_lanes.find(id);
+
+    if (it != m_lanes.end())
+        return it->second;
+
+    const std::uint32_t lane = static_cast<std::uint32_t>(m_laneNames.size());
+    m_lanes[id] = lane;
+
+    std::stringstream ss;
+    ss << "thread " << lane;
+    m_laneNames.push_back(ss.str());
+
+    return lane;
+}
+
+//
+// ScopedProfileEvent class implementation.
+//
+
+ScopedProfileEvent::ScopedProfileEvent(ExportProfiler& profiler, const char* phase)
+  : m_profiler(profiler.isEnabled() ? &profiler : nullptr)
+  , m_phase(phase)
+  , m_start(0)
+{
+    if (m_profiler)
+        m_start = m_profiler->now();
+}
+
+ScopedProfileEvent::ScopedProfileEvent(ExportProfiler& profiler, const char* phase, const NodeKey& node)
+  : m_profiler(profiler.isEnabled() ? &profiler : nullptr)
+  , m_phase(phase)
+  , m_start(0)
+{
+    if (m_profiler == nullptr)
+        return;
+
+    getNodeTypeAndName(node, m_nodeType, m_nodeName);
+
+    // Do not count the name lookups.
+    m_start = m_profiler->now();
+}
+
+ScopedProfileEvent::~ScopedProfileEvent()
+{
+    if (m_profiler)
+        m_profiler->addEvent(m_phase, m_nodeType, m_nodeName, m_start, m_profiler->now());
+}
+
+ProfiledTileCallbackFactory::ProfiledTileCallbackFactory(
+    ExportProfiler&                 profiler,
+    asr::ITileCallbackFactory*      factory)
+  : m_profiler(profiler)
+  , m_factory(factory)
+  , m_firstPixelRendered(false)
+{
+}
+
+void ProfiledTileCallbackFactory::release()
+{
+    delete this;
+}
+
+asr::ITileCallback* ProfiledTileCallbackFactory::create()
+{
+    return new ProfiledTileCallback(*this, m_factory ? m_factory->create() : nullptr);
+}
+
+void ProfiledTileCallbackFactory::pixelsRendered()
+{
+    if (!m_firstPixelRendered.exchange(true))
+        m_profiler.addEvent("firstPixel", std::string(), std::string(), 0, m_profiler.now());
+}
@@ -0,0 +1,165 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed-maya headers.
+#include "appleseedmaya/nodemap.h"
+
+// Build options header.
+#include "foundation/core/buildoptions.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/rendering.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Standard headers.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//
+// ExportProfiler.
+//
+//  Collects timed events during an export / render session.
+//  Events are grouped in phases (createEntities, flushEntities...),
+//  optionally tagged with the Maya node and node type they belong to,
+//  and recorded in one lane per thread. The result can be saved as a
+//  Chrome / Perfetto trace and summarized in the log.
+//
+
+class ExportProfiler
+  : public foundation::NonCopyable
+{
+  public:
+    ExportProfiler();
+
+    bool isEnabled() const;
+
+    // Enable or disable profiling. Enabling the profiler clears previous events.
+    void setEnabled(const bool enabled);
+
+    // Name the lane of the calling thread.
+    void setThreadName(const char* name);
+
+    // Return the time elapsed since the profiler was enabled, in microseconds.
+    std::uint64_t now() const;
+
+    // Record a completed event. Thread safe.
+    void addEvent(
+        const char*             phase,
+        const std::string&      nodeType,
+        const std::string&      nodeName,
+        const std::uint64_t     start,
+        const std::uint64_t     end);
+
+    // Write the events as a Chrome trace event JSON file.
+    bool writeChromeTrace(const std::string& filename) const;
+
+    // Log the time spent per phase, per node type and in the slowest nodes.
+    void logSummary() const;
+
+  private:
+    struct Event
+    {
+        const char*     m_phase;
+        std::string     m_nodeType;
+        std::string     m_nodeName;
+        std::uint64_t   m_start;
+        std::uint64_t   m_duration;
+        std::uint32_t   m_lane;
+    };
+
+    std::uint32_t laneForCurrentThread();
+
+    bool                                                m_enabled;
+    std::chrono::steady_clock::time_point               m_origin;
+    mutable std::mutex                                  m_mutex;
+    std::vector<Event>                                  m_events;
+    std::map<std::thread::id, std::uint32_t>            m_lanes;
+    std::vector<std::string>                            m_laneNames;
+};
+
+//
+// ScopedProfileEvent.
+//
+//  Records an event covering its lifetime. Node names and types are
+//  only looked up when the profiler is enabled.
+//
+
+class ScopedProfileEvent
+  : public foundation::NonCopyable
+{
+  public:
+    ScopedProfileEvent(ExportProfiler& profiler, const char* phase);
+    ScopedProfileEvent(ExportProfiler& profiler, const char* phase, const NodeKey& node);
+
+    ~ScopedProfileEvent();
+
+  private:
+    ExportProfiler*     m_profiler;
+    const char*         m_phase;
+    std::string         m_nodeType;
+    std::string         m_nodeName;
+    std::uint64_t       m_start;
+};
+
+//
+// ProfiledTileCallbackFactory.
+//
+//  Wraps an optional tile callback factory and records the time from the
+//  start of the session to the first finished tile, as a firstPixel event.
+//
+
+class ProfiledTileCallbackFactory
+  : public renderer::ITileCallbackFactory
+{
+  public:
+    ProfiledTileCallbackFactory(
+        ExportProfiler&                     profiler,
+        renderer::ITileCallbackFactory*     factory);
+
+    void release() override;
+
+    renderer::ITileCallback* create() override;
+
+    // Called by the tile callbacks when a tile or a progressive frame is done.
+    void pixelsRendered();
+
+  private:
+    ExportProfiler&                     m_profiler;
+    renderer::ITileCallbackFactory*     m_factory;
+    std::atomic<bool>                   m_firstPixelRendered;
+};
@@ -226,6 +226,63 @@ namespace
         AttributeUtils::makeInput(numAttrFn);
         modifier.addExtensionAttribute(nodeClass, attr);
 
+        attr = createNumericAttribute<bool>(
+            numAttrFn,
+            "asStandIn",
+            "asStandIn",
+            MFnNumericData::kBoolean,
+            false,
+            status);
+        AttributeUtils::makeInput(numAttrFn);
+        modifier.addExtensionAttribute(nodeClass, attr);
+
+        MFnEnumAttribute enumAttrFn;
+        attr = enumAttrFn.create(
+            "asMotionBlurSamplesMode",
+            "asMotionBlurSamplesMode",
+            0);
+        enumAttrFn.addField("Use Render Settings", 0);
+        enumAttrFn.addField("Custom", 1);
+        enumAttrFn.addField("Adaptive", 2);
+        AttributeUtils::makeInput(enumAttrFn);
+        modifier.addExtensionAttribute(nodeClass, attr);
+
+        attr = createNumericAttribute<int>(
+            numAttrFn,
+            "asTransformMotionSamples",
+            "asTransformMotionSamples",
+            MFnNumericData::kInt,
+            2,
+            status);
+        numAttrFn.setMin(1);
+        numAttrFn.setSoftMax(16);
+        AttributeUtils::makeInput(numAttrFn);
+        modifier.addExtensionAttribute(nodeClass, attr);
+
+        attr = createNumericAttribute<int>(
+            numAttrFn,
+            "asDeformMotionSamples",
+            "asDeformMotionSamples",
+            MFnNumericData::kInt,
+            2,
+            status);
+        numAttrFn.setMin(1);
+        numAttrFn.setSoftMax(16);
+        AttributeUtils::makeInput(numAttrFn);
+        modifier.addExtensionAttribute(nodeClass, attr);
+
+        attr = createNumericAttribute<float>(
+            numAttrFn,
+            "asMotionBlurTolerance",
+            "asMotionBlurTolerance",
+            MFnNumericData::kFloat,
+            0.001f,
+            status);
+        numAttrFn.setMin(0.00001f);
+        numAttrFn.setSoftMax(0.1f);
+        AttributeUtils::makeInput(numAttrFn);
+        modifier.addExtensionAttribute(nodeClass, attr);
+
         addVisibilityExtensionAttributes(nodeClass, modifier);
         modifier.doIt();
     }
@@ -448,6 +505,76 @@ namespace
 
         modifier.doIt();
     }
+
+#ifdef APPLESEED_MAYA_WITH_XGEN
+    void addXGenDescriptionExtensionAttrs()
+    {
+        MNodeClass nodeClass("xgmDescription");
+        MDGModifier modifier;
+
+        MStatus status;
+
+        MFnNumericAttribute numAttrFn;
+
+        MObject attr = createNumericAttribute<bool>(
+            numAttrFn,
+            "asLodEnable",
+            "asLodEnable",
+            MFnNumericData::kBoolean,
+            false,
+            status);
+        AttributeUtils::makeInput(numAttrFn);
+        modifier.addExtensionAttribute(nodeClass, attr);
+
+        attr = createNumericAttribute<float>(
+            numAttrFn,
+            "asDensityFalloffStart",
+            "asDensityFalloffStart",
+            MFnNumericData::kFloat,
+            10.0f,
+            status);
+        numAttrFn.setMin(0.0f);
+        numAttrFn.setSoftMax(1000.0f);
+        AttributeUtils::makeInput(numAttrFn);
+        modifier.addExtensionAttribute(nodeClass, attr);
+
+        attr = createNumericAttribute<float>(
+            numAttrFn,
+            "asDensityFalloffEnd",
+            "asDensityFalloffEnd",
+            MFnNumericData::kFloat,
+            100.0f,
+            status);
+        numAttrFn.setMin(0.0f);
+        numAttrFn.setSoftMax(10000.0f);
+        AttributeUtils::makeInput(numAttrFn);
+        modifier.addExtensionAttribute(nodeClass, attr);
+
+        attr = createNumericAttribute<float>(
+            numAttrFn,
+            "asMinDensity",
+            "asMinDensity",
+            MFnNumericData::kFloat,
+            0.1f,
+            status);
+        numAttrFn.setMin(0.001f);
+        numAttrFn.setMax(1.0f);
+        AttributeUtils::makeInput(numAttrFn);
+        modifier.addExtensionAttribute(nodeClass, attr);
+
+        attr = createNumericAttribute<bool>(
+            numAttrFn,
+            "asWidthCompensation",
+            "asWidthCompensation",
+            MFnNumericData::kBoolean,
+            true,
+            status);
+        AttributeUtils::makeInput(numAttrFn);
+        modifier.addExtensionAttribute(nodeClass, attr);
+
+        modifier.doIt();
+    }
+#endif
 }
 
 MStatus addExtensionAttributes()
@@ -458,5 +585,8 @@ MStatus addExtensionAttributes()
     addBump2dExtensionAttributes();
     addShadingEngineExtensionAttrs();
     addCameraExtensionAttrs();
+#ifdef APPLESEED_MAYA_WITH_XGEN
+    addXGenDescriptionExtensionAttrs();
+#endif
     return MS::kSuccess;
 }
@@ -0,0 +1,289 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "geometryconversion.h"
+
+// appleseed-maya headers.
+#include "appleseedmaya/kernelconfig.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#ifdef APPLESEED_MAYA_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+    // Below this many vectors, threading costs more than it saves.
+    const size_t ParallelGrainSize = 64 * 1024;
+
+    void normalizeRange(
+        const float*    src,
+        const size_t    begin,
+        const size_t    end,
+        float*          dst)
+    {
+        size_t i = begin;
+
+#ifdef APPLESEED_MAYA_USE_SSE
+        // Four vectors at a time, transposed to SoA form.
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        for (; i + 4 <= end; i += 4)
+        {
+            const float* s = src + 3 * i;
+            const __m128 a = _mm_loadu_ps(s);       // x0 y0 z0 x1
+            const __m128 b = _mm_loadu_ps(s + 4);   // y1 z1 x2 y2
+            const __m128 c = _mm_loadu_ps(s + 8);   // z2 x3 y3 z3
+
+            __m128 x = _mm_shuffle_ps(
+                _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 3, 0, 0)),
+                _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2)),
+                _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 y = _mm_shuffle_ps(
+                _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 1)),
+                _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 2, 0, 3)),
+                _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 z = _mm_shuffle_ps(
+                _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 1, 0, 2)),
+                _mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 3, 0, 0)),
+                _MM_SHUFFLE(2, 0, 2, 0));
+
+            const __m128 len2 =
+                _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+                    _mm_mul_ps(z, z));
+
+            // Exact division, to match the scalar version.
+            const __m128 valid = _mm_cmpgt_ps(len2, zero);
+            const __m128 rcp = _mm_div_ps(one, _mm_sqrt_ps(len2));
+
+            x = _mm_and_ps(valid, _mm_mul_ps(x, rcp));
+            y = _mm_or_ps(_mm_and_ps(valid, _mm_mul_ps(y, rcp)), _mm_andnot_ps(valid, one));
+            z = _mm_and_ps(valid, _mm_mul_ps(z, rcp));
+
+            // Back to AoS form.
+            const __m128 xy_lo = _mm_unpacklo_ps(x, y);  // x0 y0 x1 y1
+            const __m128 xy_hi = _mm_unpackhi_ps(x, y);  // x2 y2 x3 y3
+
+            float* d = dst + 3 * i;
+            _mm_storeu_ps(
+                d,
+                _mm_shuffle_ps(
+                    xy_lo,
+                    _mm_shuffle_ps(z, xy_lo, _MM_SHUFFLE(0, 2, 0, 0)),
+                    _MM_SHUFFLE(2, 0, 1, 0)));
+            _mm_storeu_ps(
+                d + 4,
+                _mm_shuffle_ps(
+                    _mm_shuffle_ps(xy_lo, z, _MM_SHUFFLE(0, 1, 0, 3)),
+                    xy_hi,
+                    _MM_SHUFFLE(1, 0, 2, 0)));
+            _mm_storeu_ps(
+                d + 8,
+                _mm_shuffle_ps(
+                    _mm_shuffle_ps(z, xy_hi, _MM_SHUFFLE(0, 2, 0, 2)),
+                    _mm_shuffle_ps(xy_hi, z, _MM_SHUFFLE(0, 3, 0, 3)),
+                    _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+#endif
+
+        if (i < end)
+            normalizeVectorsScalar(src + 3 * i, end - i, dst + 3 * i);
+    }
+}
+
+void normalizeVectors(
+    const float*    src,
+    const size_t    count,
+    float*          dst)
+{
+    const size_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    const size_t threadCount = std::min(count / ParallelGrainSize, maxThreads);
+
+    if (threadCount <= 1)
+    {
+        normalizeRange(src, 0, count, dst);
+        return;
+    }
+
+    // Split in contiguous chunks, the calling thread processes the last one.
+    const size_t chunkSize = (count + threadCount - 1) / threadCount;
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+
+    for (size_t t = 0; t + 1 < threadCount; ++t)
+        threads.emplace_back(normalizeRange, src, t * chunkSize, (t + 1) * chunkSize, dst);
+
+    normalizeRange(src, (threadCount - 1) * chunkSize, count, dst);
+
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+void normalizeVectorsScalar(
+    const float*    src,
+    const size_t    count,
+    float*          dst)
+{
+    for (size_t i = 0; i < count; ++i, src += 3, dst += 3)
+    {
+        const float len2 = src[0] * src[0] + src[1] * src[1] + src[2] * src[2];
+
+        if (len2 > 0.0f)
+        {
+            const float rcp = 1.0f / std::sqrt(len2);
+            dst[0] = src[0] * rcp;
+            dst[1] = src[1] * rcp;
+            dst[2] = src[2] * rcp;
+        }
+        else
+        {
+            dst[0] = 0.0f;
+            dst[1] = 1.0f;
+            dst[2] = 0.0f;
+        }
+    }
+}
+
+void interleaveUVs(
+    const float*    u,
+    const float*    v,
+    const size_t    count,
+    float*          dst)
+{
+    for (size_t i = 0; i < count; ++i, dst += 2)
+    {
+        dst[0] = u[i];
+        dst[1] = v[i];
+    }
+}
+
+PolygonMeshTopology::PolygonMeshTopology()
+  : m_faceCount(0)
+  , m_faceVertexCounts(nullptr)
+  , m_faceVertices(nullptr)
+  , m_faceTriangleCounts(nullptr)
+  , m_triangleVertices(nullptr)
+  , m_faceUVCounts(nullptr)
+  , m_faceUVs(nullptr)
+  , m_faceNormals(nullptr)
+  , m_faceMaterials(nullptr)
+{
+}
+
+void triangulateFaces(
+    const PolygonMeshTopology&      mesh,
+    std::vector<TriangleIndices>&   triangles)
+{
+    size_t triangleCount = 0;
+    for (size_t f = 0; f < mesh.m_faceCount; ++f)
+        triangleCount += static_cast<size_t>(mesh.m_faceTriangleCounts[f]);
+
+    triangles.resize(triangleCount);
+
+    const int* faceVertices = mesh.m_faceVertices;
+    const int* faceUVs = mesh.m_faceUVs;
+    const int* faceNormals = mesh.m_faceNormals;
+    const int* triangleVertices = mesh.m_triangleVertices;
+    TriangleIndices* triangle = triangles.data();
+
+    for (size_t f = 0; f < mesh.m_faceCount; ++f)
+    {
+        const size_t vertexCount = static_cast<size_t>(mesh.m_faceVertexCounts[f]);
+
+        // Faces without UVs have no entries in the UV index array.
+        const bool hasUVs =
+            faceUVs != nullptr &&
+            (mesh.m_faceUVCounts == nullptr || static_cast<size_t>(mesh.m_faceUVCounts[f]) == vertexCount);
+
+        const std::uint32_t material =
+            mesh.m_faceMaterials ? static_cast<std::uint32_t>(mesh.m_faceMaterials[f]) : 0;
+
+        for (int t = 0, te = mesh.m_faceTriangleCounts[f]; t < te; ++t)
+        {
+            // Find the face vertex of each triangle vertex.
+            size_t offset[3] = {0, 0, 0};
+            for (size_t k = 0; k < 3; ++k)
+            {
+                for (size_t j = 0; j < vertexCount; ++j)
+                {
+                    if (faceVertices[j] == triangleVertices[k])
+                    {
+                        offset[k] = j;
+                        break;
+                    }
+                }
+            }
+
+            triangle->m_v0 = static_cast<std::uint32_t>(triangleVertices[0]);
+            triangle->m_v1 = static_cast<std::uint32_t>(triangleVertices[1]);
+            triangle->m_v2 = static_cast<std::uint32_t>(triangleVertices[2]);
+
+            if (faceNormals)
+            {
+                triangle->m_n0 = static_cast<std::uint32_t>(faceNormals[offset[0]]);
+                triangle->m_n1 = static_cast<std::uint32_t>(faceNormals[offset[1]]);
+                triangle->m_n2 = static_cast<std::uint32_t>(faceNormals[offset[2]]);
+            }
+            else
+                triangle->m_n0 = triangle->m_n1 = triangle->m_n2 = 0;
+
+            if (hasUVs)
+            {
+                triangle->m_a0 = static_cast<std::uint32_t>(faceUVs[offset[0]]);
+                triangle->m_a1 = static_cast<std::uint32_t>(faceUVs[offset[1]]);
+                triangle->m_a2 = static_cast<std::uint32_t>(faceUVs[offset[2]]);
+            }
+            else
+                triangle->m_a0 = triangle->m_a1 = triangle->m_a2 = 0;
+
+            triangle->m_pa = material;
+
+            triangleVertices += 3;
+            ++triangle;
+        }
+
+        faceVertices += vertexCount;
+
+        if (faceNormals)
+            faceNormals += vertexCount;
+
+        if (faceUVs && mesh.m_faceUVCounts)
+            faceUVs += mesh.m_faceUVCounts[f];
+        else if (faceUVs)
+            faceUVs += vertexCount;
+    }
+}
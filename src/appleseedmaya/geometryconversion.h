@@ -0,0 +1,93 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+// Geometry conversion kernels.
+//
+//  Bulk conversions from Maya mesh arrays to the layouts used by appleseed
+//  mesh objects. Vectors are tightly packed float triples.
+//
+
+// Normalize count vectors. Zero length vectors are replaced by (0, 1, 0).
+// Large arrays are split across threads.
+void normalizeVectors(
+    const float*    src,
+    const size_t    count,
+    float*          dst);
+
+// Scalar reference version of normalizeVectors.
+void normalizeVectorsScalar(
+    const float*    src,
+    const size_t    count,
+    float*          dst);
+
+// Interleave separate u and v arrays into (u, v) pairs.
+void interleaveUVs(
+    const float*    u,
+    const float*    v,
+    const size_t    count,
+    float*          dst);
+
+// Polygonal mesh topology, in the layout returned by Maya's MFnMesh
+// getVertices(), getTriangles(), getAssignedUVs() and getNormalIds().
+struct PolygonMeshTopology
+{
+    PolygonMeshTopology();
+
+    size_t          m_faceCount;
+    const int*      m_faceVertexCounts;     // vertices per face
+    const int*      m_faceVertices;         // vertex index per face vertex
+    const int*      m_faceTriangleCounts;   // triangles per face
+    const int*      m_triangleVertices;     // 3 vertex indices per triangle
+    const int*      m_faceUVCounts;         // UVs per face, optional
+    const int*      m_faceUVs;              // UV index per face vertex of faces with UVs, optional
+    const int*      m_faceNormals;          // normal index per face vertex, optional
+    const int*      m_faceMaterials;        // material slot per face, optional
+};
+
+// Triangle indices, in the layout of appleseed triangles.
+struct TriangleIndices
+{
+    std::uint32_t   m_v0, m_v1, m_v2;       // vertex indices
+    std::uint32_t   m_n0, m_n1, m_n2;       // vertex normal indices
+    std::uint32_t   m_a0, m_a1, m_a2;       // vertex attribute (UV) indices
+    std::uint32_t   m_pa;                   // primitive attribute (material slot) index
+};
+
+// Match the triangles of each face to the face vertices, to find their
+// normal and UV indices. Missing normals, UVs and materials are set to 0.
+void triangulateFaces(
+    const PolygonMeshTopology&      mesh,
+    std::vector<TriangleIndices>&   triangles);
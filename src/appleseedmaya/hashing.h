@@ -0,0 +1,55 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+// Hashing kernels.
+//
+//  Plain buffer versions of the hashing done during exports.
+//
+
+// Append bytes to a 128 bit MurmurHash3 state.
+// Based on code available at http://code.google.com/p/smhasher.
+void murmurHash3Append(
+    std::uint64_t&          h1,
+    std::uint64_t&          h2,
+    const void*             data,
+    const size_t            bytes);
+
+// Find the objects sharing the same 128 bit hash, stored as two words per object.
+// masters[i] is set to the index of the first object with the same hash as object i.
+void findInstanceMasters(
+    const std::uint64_t*    hashes,
+    const size_t            count,
+    std::vector<size_t>&    masters);
@@ -29,6 +29,698 @@
 // Interface header.
 #include "hypershaderenderer.h"
 
+// appleseed-maya headers.
+#include "appleseedmaya/appleseedsession.h"
+#include "appleseedmaya/attributeutils.h"
+#include "appleseedmaya/geometryconversion.h"
+#include "appleseedmaya/logger.h"
+#include "appleseedmaya/meshutils.h"
+#include "appleseedmaya/pixelconversion.h"
+#include "appleseedmaya/renderercontroller.h"
+#include "appleseedmaya/utils.h"
+
+// Build options header.
+#include "foundation/core/buildoptions.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/camera.h"
+#include "renderer/api/color.h"
+#include "renderer/api/environment.h"
+#include "renderer/api/environmentedf.h"
+#include "renderer/api/environmentshader.h"
+#include "renderer/api/frame.h"
+#include "renderer/api/light.h"
+#include "renderer/api/material.h"
+#include "renderer/api/object.h"
+#include "renderer/api/project.h"
+#include "renderer/api/rendering.h"
+#include "renderer/api/scene.h"
+#include "renderer/api/shadergroup.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/memory/autoreleaseptr.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/image/tile.h"
+#include "foundation/math/matrix.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/searchpaths.h"
+
+// Maya headers.
+#include "appleseedmaya/_beginmayaheaders.h"
+#include <maya/MColor.h>
+#include <maya/MFnCamera.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MFnMesh.h>
+#include <maya/MIntArray.h>
+#include <maya/MMatrix.h>
+#include <maya/MPlug.h>
+#include <maya/MUuid.h>
+#include "appleseedmaya/_endmayaheaders.h"
+
+// Standard headers.
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace asf = foundation;
+namespace asr = renderer;
+
+namespace
+{
+    const unsigned int DefaultResolution = 256;
+    const unsigned int DefaultMaxSamples = 64;
+
+    asf::Matrix4d convert(const MMatrix& m)
+    {
+        asf::Matrix4d result;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+                result(i, j) = m[j][i];
+        }
+
+        return result;
+    }
+
+    MString entityName(const MUuid& id)
+    {
+        return id.asString();
+    }
+
+    asf::auto_release_ptr<asr::MeshObject> createMeshObject(
+        const MString&  name,
+        const MObject&  node)
+    {
+        MStatus status;
+        MFnMesh meshFn(node, &status);
+
+        asf::auto_release_ptr<asr::MeshObject> mesh(
+            asr::MeshObjectFactory().create(name.asChar(), asr::ParamArray()));
+
+        if (!status)
+            return mesh;
+
+        const bool hasUVs = meshFn.numUVs() != 0;
+
+        // Vertices.
+        std::vector<asr::GVector3> points;
+        MeshUtils::copyPoints(meshFn, points);
+
+        mesh->reserve_vertices(points.size());
+        for (const asr::GVector3& p : points)
+            mesh->push_vertex(p);
+
+        // UVs.
+        if (hasUVs)
+        {
+            std::vector<asr::GVector2> uvs;
+            MeshUtils::copyUVs(meshFn, uvs);
+
+            mesh->reserve_tex_coords(uvs.size());
+            for (const asr::GVector2& uv : uvs)
+                mesh->push_tex_coords(uv);
+        }
+
+        // Normals.
+        std::vector<asr::GVector3> normals;
+        MeshUtils::copyNormals(meshFn, normals);
+
+        mesh->reserve_vertex_normals(normals.size());
+        for (const asr::GVector3& n : normals)
+            mesh->push_vertex_normal(n);
+
+        // Triangles.
+        MIntArray faceVertexCounts, faceVertices;
+        meshFn.getVertices(faceVertexCounts, faceVertices);
+
+        MIntArray faceTriangleCounts, triangleVertices;
+        meshFn.getTriangles(faceTriangleCounts, triangleVertices);
+
+        MIntArray faceNormalCounts, faceNormals;
+        meshFn.getNormalIds(faceNormalCounts, faceNormals);
+
+        PolygonMeshTopology topology;
+        topology.m_faceCount = faceVertexCounts.length();
+        topology.m_faceVertexCounts = MeshUtils::intArrayData(faceVertexCounts);
+        topology.m_faceVertices = MeshUtils::intArrayData(faceVertices);
+        topology.m_faceTriangleCounts = MeshUtils::intArrayData(faceTriangleCounts);
+        topology.m_triangleVertices = MeshUtils::intArrayData(triangleVertices);
+        topology.m_faceNormals = MeshUtils::intArrayData(faceNormals);
+
+        MIntArray faceUVCounts, faceUVs;
+        if (hasUVs)
+        {
+            meshFn.getAssignedUVs(faceUVCounts, faceUVs);
+            topology.m_faceUVCounts = MeshUtils::intArrayData(faceUVCounts);
+            topology.m_faceUVs = MeshUtils::intArrayData(faceUVs);
+        }
+
+        std::vector<TriangleIndices> triangles;
+        triangulateFaces(topology, triangles);
+
+        mesh->reserve_triangles(triangles.size());
+        for (size_t i = 0, e = triangles.size(); i < e; ++i)
+        {
+            const TriangleIndices& t = triangles[i];
+
+            asr::Triangle triangle(t.m_v0, t.m_v1, t.m_v2, 0);
+            triangle.m_n0 = t.m_n0;
+            triangle.m_n1 = t.m_n1;
+            triangle.m_n2 = t.m_n2;
+
+            if (hasUVs)
+            {
+                triangle.m_a0 = t.m_a0;
+                triangle.m_a1 = t.m_a1;
+                triangle.m_a2 = t.m_a2;
+            }
+
+            mesh->push_triangle(triangle);
+        }
+
+        mesh->push_material_slot("default");
+        return mesh;
+    }
+
+    //
+    // Tile callback that sends progressive frame updates to the Hypershade renderer.
+    //
+
+    class HypershadeTileCallback
+      : public asr::TileCallbackBase
+    {
+      public:
+        explicit HypershadeTileCallback(HypershadeRenderer& renderer)
+          : m_renderer(renderer)
+        {
+        }
+
+        void release() override
+        {
+            delete this;
+        }
+
+        void on_progressive_frame_update(
+            const asr::Frame&       frame,
+            const double            time,
+            const std::uint64_t     samples,
+            const double            samples_per_pixel,
+            const std::uint64_t     samples_per_second) override
+        {
+            const asf::CanvasProperties& props = frame.image().properties();
+            const size_t width = props.m_canvas_width;
+            const size_t height = props.m_canvas_height;
+
+            m_pixels.resize(width * height * 4);
+
+            for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+            {
+                for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+                {
+                    const asf::Tile& tile = frame.image().tile(tx, ty);
+                    const size_t x0 = tx * props.m_tile_width;
+                    const size_t y0 = ty * props.m_tile_height;
+                    const size_t w = std::min(tile.get_width(), width - x0);
+                    const size_t h = std::min(tile.get_height(), height - y0);
+
+                    for (size_t j = 0; j < h; ++j)
+                    {
+                        // Maya expects rows from bottom to top.
+                        const size_t y = height - 1 - (y0 + j);
+                        copyFloatRGBA(
+                            reinterpret_cast<const float*>(tile.pixel(0, j)),
+                            w,
+                            m_pixels.data() + (y * width + x0) * 4);
+                    }
+                }
+            }
+
+            MPxRenderer::RefreshParams params;
+            params.width = static_cast<unsigned int>(width);
+            params.height = static_cast<unsigned int>(height);
+            params.left = 0;
+            params.right = params.width - 1;
+            params.bottom = 0;
+            params.top = params.height - 1;
+            params.channels = 4;
+            params.bytesPerChannel = sizeof(float);
+            params.data = m_pixels.data();
+            m_renderer.refresh(params);
+        }
+
+      private:
+        HypershadeRenderer& m_renderer;
+        std::vector<float>  m_pixels;
+    };
+
+    class HypershadeTileCallbackFactory
+      : public asr::ITileCallbackFactory
+    {
+      public:
+        explicit HypershadeTileCallbackFactory(HypershadeRenderer& renderer)
+          : m_renderer(renderer)
+        {
+        }
+
+        void release() override
+        {
+            delete this;
+        }
+
+        asr::ITileCallback* create() override
+        {
+            return new HypershadeTileCallback(m_renderer);
+        }
+
+      private:
+        HypershadeRenderer& m_renderer;
+    };
+}
+
+//
+// Persistent appleseed scene for the Hypershade renderer.
+//
+//  Entities are named after the Maya UUIDs of the objects they translate.
+//  Object instances, light and camera transforms are rebuilt in commit(),
+//  once Maya has finished pushing a batch of scene deltas.
+//
+
+class HypershadeScene
+  : public asf::NonCopyable
+{
+  public:
+    HypershadeScene()
+      : m_width(DefaultResolution)
+      , m_height(DefaultResolution)
+      , m_isRendering(false)
+    {
+        m_project = asr::ProjectFactory::create("hypershade");
+        m_project->add_default_configurations();
+
+        asr::ParamArray& params = m_project->configurations().get_by_name("interactive")->get_parameters();
+        params.insert("sample_renderer", "generic");
+        params.insert("sample_generator", "generic");
+        params.insert("tile_renderer", "generic");
+        params.insert("pixel_renderer", "uniform");
+        params.insert("sampling_mode", "qmc");
+        params.insert("lighting_engine", "pt");
+        params.insert("spectrum_mode", "rgb");
+        params.insert("frame_renderer", "progressive");
+        params.insert_path("progressive_frame_renderer.max_fps", "5");
+
+        m_project->set_scene(asr::SceneFactory::create());
+
+        // Fallback camera, used until Maya sends one.
+        asf::auto_release_ptr<asr::Camera> camera = asr::PinholeCameraFactory().create(
+            "defaultCamera",
+            asr::ParamArray()
+                .insert("film_dimensions", "0.0359999 0.0359999")
+                .insert("focal_length", "0.035"));
+        camera->transform_sequence().set_transform(
+            0.0f,
+            asf::Transformd(asf::Matrix4d::make_translation(asf::Vector3d(0.0, 0.0, 2.65))));
+        m_project->get_scene()->cameras().insert(camera);
+        m_cameraName = "defaultCamera";
+
+        asf::auto_release_ptr<asr::Assembly> assembly = asr::AssemblyFactory().create("assembly", asr::ParamArray());
+        m_mainAssembly = assembly.get();
+        m_project->get_scene()->assemblies().insert(assembly);
+
+        asf::auto_release_ptr<asr::AssemblyInstance> assemblyInstance = asr::AssemblyInstanceFactory::create(
+            "assembly_inst",
+            asr::ParamArray(),
+            "assembly");
+        m_project->get_scene()->assembly_instances().insert(assemblyInstance);
+
+        createFrame();
+    }
+
+    ~HypershadeScene()
+    {
+        stopRender();
+    }
+
+    void startRender(HypershadeRenderer& renderer, const unsigned int maxSamples)
+    {
+        stopRender();
+
+        asr::ParamArray params =
+            m_project->configurations().get_by_name("interactive")->get_inherited_parameters();
+        params.insert_path("progressive_frame_renderer.max_average_spp", maxSamples);
+
+        m_rendererController.set_status(asr::IRendererController::ContinueRendering);
+        m_tileCallbackFactory.reset(new HypershadeTileCallbackFactory(renderer));
+        m_renderer.reset(
+            new asr::MasterRenderer(
+                *m_project,
+                params,
+                m_resourceSearchPaths,
+                static_cast<asr::ITileCallbackFactory*>(m_tileCallbackFactory.get())));
+
+        m_isRendering = true;
+        std::thread thread(&HypershadeScene::renderFunc, this);
+        m_renderThread.swap(thread);
+    }
+
+    void stopRender()
+    {
+        m_rendererController.set_status(asr::IRendererController::AbortRendering);
+
+        if (m_renderThread.joinable())
+            m_renderThread.join();
+
+        m_renderer.reset();
+        m_tileCallbackFactory.reset();
+    }
+
+    // The render thread stays joinable after the render ends,
+    // until the next startRender or stopRender.
+    bool isRendering() const
+    {
+        return m_isRendering;
+    }
+
+    void setResolution(const unsigned int width, const unsigned int height)
+    {
+        m_width = std::max(width, 1u);
+        m_height = std::max(height, 1u);
+        createFrame();
+    }
+
+    void translateMesh(const MUuid& id, const MObject& node)
+    {
+        const MString name = entityName(id);
+        removeObject(name);
+
+        asf::auto_release_ptr<asr::MeshObject> mesh = createMeshObject(name, node);
+        m_mainAssembly->objects().insert(asf::auto_release_ptr<asr::Object>(mesh.release()));
+        m_meshes.insert(name);
+    }
+
+    void translateShader(const MUuid& id, const MObject& node)
+    {
+        const MString classification =
+            MFnDependencyNode::classification(MFnDependencyNode(node).typeName());
+
+        asf::auto_release_ptr<asr::ShaderGroup> shaderGroup;
+        if (strstr(classification.asChar(), "rendernode/appleseed/texture") != nullptr)
+            shaderGroup = AppleseedSession::exportTextureSwatch(node);
+        else
+            shaderGroup = AppleseedSession::exportMaterialSwatch(node);
+
+        if (shaderGroup.get() == nullptr)
+        {
+            RENDERER_LOG_WARNING(
+                "Hypershade: could not translate shader %s",
+                MFnDependencyNode(node).name().asChar());
+            return;
+        }
+
+        // Name the shader group and material after the Maya shader.
+        const MString name = entityName(id);
+        const MString materialName = name + MString("_material");
+        removeShader(name);
+
+        shaderGroup->set_name(name.asChar());
+        m_mainAssembly->shader_groups().insert(shaderGroup);
+
+        asf::auto_release_ptr<asr::Material> material = asr::OSLMaterialFactory().create(
+            materialName.asChar(),
+            asr::ParamArray().insert("osl_surface", name.asChar()));
+        m_mainAssembly->materials().insert(material);
+
+        m_shaders[name] = materialName;
+    }
+
+    void translateLight(const MUuid& id, const MObject& node)
+    {
+        MFnDependencyNode depNodeFn(node);
+        const MString name = entityName(id);
+        const MString colorName = name + MString("_color");
+        removeLight(name);
+
+        MColor color(1.0f, 1.0f, 1.0f);
+        AttributeUtils::get(node, "color", color);
+
+        float intensity = 1.0f;
+        AttributeUtils::get(node, "intensity", intensity);
+
+        asr::ColorValueArray values(3, &color.r);
+        m_mainAssembly->colors().insert(
+            asr::ColorEntityFactory::create(
+                colorName.asChar(),
+                asr::ParamArray().insert("color_space", "linear_rgb"),
+                values));
+
+        asf::auto_release_ptr<asr::Light> light;
+        if (depNodeFn.typeName() == "directionalLight")
+        {
+            light = asr::DirectionalLightFactory().create(
+                name.asChar(),
+                asr::ParamArray()
+                    .insert("irradiance", colorName.asChar())
+                    .insert("irradiance_multiplier", intensity));
+        }
+        else
+        {
+            light = asr::PointLightFactory().create(
+                name.asChar(),
+                asr::ParamArray()
+                    .insert("intensity", colorName.asChar())
+                    .insert("intensity_multiplier", intensity));
+        }
+
+        m_mainAssembly->lights().insert(light);
+        m_lights.insert(name);
+    }
+
+    void setLightIntensity(const MUuid& id, const float intensity)
+    {
+        asr::Light* light = m_mainAssembly->lights().get_by_name(entityName(id).asChar());
+        if (light == nullptr)
+            return;
+
+        const char* multiplier =
+            light->get_parameters().strings().exist("irradiance_multiplier")
+                ? "irradiance_multiplier"
+                : "intensity_multiplier";
+        light->get_parameters().insert(multiplier, intensity);
+    }
+
+    void translateCamera(const MUuid& id, const MObject& node)
+    {
+        MFnCamera cameraFn(node);
+        const MString name = entityName(id);
+
+        if (asr::Camera* camera = m_project->get_scene()->cameras().get_by_name(name.asChar()))
+            m_project->get_scene()->cameras().remove(camera);
+
+        const double imageAspect = static_cast<double>(m_width) / m_height;
+        const double filmWidth = 0.036;
+
+        asf::auto_release_ptr<asr::Camera> camera = asr::PinholeCameraFactory().create(
+            name.asChar(),
+            asr::ParamArray()
+                .insert("film_dimensions", asf::Vector2d(filmWidth, filmWidth / imageAspect))
+                .insert("horizontal_fov", asf::rad_to_deg(cameraFn.horizontalFieldOfView())));
+        m_project->get_scene()->cameras().insert(camera);
+
+        m_cameraName = name;
+        createFrame();
+    }
+
+    void translateEnvironment()
+    {
+        if (m_project->get_scene()->get_environment() != nullptr)
+            return;
+
+        asf::auto_release_ptr<asr::EnvironmentEDF> environmentEDF(asr::ConstantEnvironmentEDFFactory().create(
+            "environmentEDF",
+            asr::ParamArray().insert("radiance", "0.1")));
+        m_project->get_scene()->environment_edfs().insert(environmentEDF);
+
+        asf::auto_release_ptr<asr::EnvironmentShader> environmentShader(asr::EDFEnvironmentShaderFactory().create(
+            "environmentShader",
+            asr::ParamArray()
+                .insert("environment_edf", "environmentEDF")
+                .insert("alpha_value", "1.0")));
+        m_project->get_scene()->environment_shaders().insert(environmentShader);
+
+        asf::auto_release_ptr<asr::Environment> environment = asr::EnvironmentFactory().create(
+            "environment",
+            asr::ParamArray().insert("environment_shader", "environmentShader"));
+        m_project->get_scene()->set_environment(environment);
+    }
+
+    void translateTransform(const MUuid& id, const MUuid& childId, const MMatrix& matrix)
+    {
+        Transform& xform = m_transforms[entityName(id)];
+        xform.m_childName = entityName(childId);
+        xform.m_matrix = convert(matrix);
+    }
+
+    void setShader(const MUuid& id, const MUuid& shaderId)
+    {
+        m_shaderAssignments[entityName(id)] = entityName(shaderId);
+    }
+
+    // Apply the pending transform and shader assignment changes.
+    void commit()
+    {
+        m_mainAssembly->object_instances().clear();
+
+        for (auto it = m_transforms.begin(), e = m_transforms.end(); it != e; ++it)
+        {
+            const MString& childName = it->second.m_childName;
+            const asf::Transformd transform = asf::Transformd::from_local_to_parent(it->second.m_matrix);
+
+            if (m_meshes.count(childName) != 0)
+            {
+                asf::StringDictionary materials;
+
+                auto assignment = m_shaderAssignments.find(childName);
+                if (assignment != m_shaderAssignments.end())
+                {
+                    auto shader = m_shaders.find(assignment->second);
+                    if (shader != m_shaders.end())
+                        materials.insert("default", shader->second.asChar());
+                }
+
+                m_mainAssembly->object_instances().insert(
+                    asr::ObjectInstanceFactory::create(
+                        it->first.asChar(),
+                        asr::ParamArray(),
+                        childName.asChar(),
+                        transform,
+                        materials,
+                        materials));
+            }
+            else if (m_lights.count(childName) != 0)
+            {
+                if (asr::Light* light = m_mainAssembly->lights().get_by_name(childName.asChar()))
+                    light->set_transform(transform);
+            }
+            else if (asr::Camera* camera = m_project->get_scene()->cameras().get_by_name(childName.asChar()))
+            {
+                camera->transform_sequence().clear();
+                camera->transform_sequence().set_transform(0.0, transform);
+            }
+        }
+    }
+
+    void clear()
+    {
+        stopRender();
+
+        m_mainAssembly->object_instances().clear();
+        m_mainAssembly->objects().clear();
+        m_mainAssembly->materials().clear();
+        m_mainAssembly->shader_groups().clear();
+        m_mainAssembly->lights().clear();
+        m_mainAssembly->colors().clear();
+
+        m_meshes.clear();
+        m_lights.clear();
+        m_shaders.clear();
+        m_shaderAssignments.clear();
+        m_transforms.clear();
+    }
+
+  private:
+    struct Transform
+    {
+        MString         m_childName;
+        asf::Matrix4d   m_matrix;
+    };
+
+    typedef std::set<MString, MStringCompareLess> NameSet;
+    typedef std::map<MString, MString, MStringCompareLess> NameMap;
+    typedef std::map<MString, Transform, MStringCompareLess> TransformMap;
+
+    void createFrame()
+    {
+        const size_t TileSize = 32;
+        asf::auto_release_ptr<asr::Frame> frame(
+            asr::FrameFactory::create(
+                "beauty",
+                asr::ParamArray()
+                    .insert("resolution", asf::Vector2u(m_width, m_height))
+                    .insert("camera", m_cameraName.asChar())
+                    .insert("tile_size", asf::Vector2i(TileSize, TileSize))));
+        m_project->set_frame(frame);
+    }
+
+    void removeObject(const MString& name)
+    {
+        if (asr::Object* object = m_mainAssembly->objects().get_by_name(name.asChar()))
+            m_mainAssembly->objects().remove(object);
+
+        m_meshes.erase(name);
+    }
+
+    void removeShader(const MString& name)
+    {
+        auto it = m_shaders.find(name);
+        if (it == m_shaders.end())
+            return;
+
+        if (asr::Material* material = m_mainAssembly->materials().get_by_name(it->second.asChar()))
+            m_mainAssembly->materials().remove(material);
+
+        if (asr::ShaderGroup* shaderGroup = m_mainAssembly->shader_groups().get_by_name(name.asChar()))
+            m_mainAssembly->shader_groups().remove(shaderGroup);
+
+        m_shaders.erase(it);
+    }
+
+    void removeLight(const MString& name)
+    {
+        if (asr::Light* light = m_mainAssembly->lights().get_by_name(name.asChar()))
+            m_mainAssembly->lights().remove(light);
+
+        const MString colorName = name + MString("_color");
+        if (asr::ColorEntity* color = m_mainAssembly->colors().get_by_name(colorName.asChar()))
+            m_mainAssembly->colors().remove(color);
+
+        m_lights.erase(name);
+    }
+
+    void renderFunc()
+    {
+        m_renderer->render(m_rendererController);
+        m_isRendering = false;
+    }
+
+    asf::auto_release_ptr<asr::Project>                  m_project;
+    asr::Assembly*                                       m_mainAssembly;
+    MString                                              m_cameraName;
+    unsigned int                                         m_width;
+    unsigned int                                         m_height;
+
+    NameSet                                              m_meshes;
+    NameSet                                              m_lights;
+    NameMap                                              m_shaders;
+    NameMap                                              m_shaderAssignments;
+    TransformMap                                         m_transforms;
+
+    asf::SearchPaths                                     m_resourceSearchPaths;
+    RendererController                                   m_rendererController;
+    asf::auto_release_ptr<HypershadeTileCallbackFactory> m_tileCallbackFactory;
+    std::unique_ptr<asr::MasterRenderer>                 m_renderer;
+    std::thread                                          m_renderThread;
+    std::atomic<bool>                                    m_isRendering;
+};
+
 const MString HypershadeRenderer::name("appleseed");
 
 void* HypershadeRenderer::creator()
@@ -37,41 +729,65 @@ void* HypershadeRenderer::creator()
 }
 
 HypershadeRenderer::HypershadeRenderer()
+  : m_scene(new HypershadeScene())
+  , m_renderRequested(false)
+  , m_maxSamples(DefaultMaxSamples)
+{
+}
+
+HypershadeRenderer::~HypershadeRenderer()
 {
 }
 
 bool HypershadeRenderer::isSafeToUnload()
 {
-    return true;
+    return !m_scene->isRendering();
 }
 
 MStatus HypershadeRenderer::startAsync(const JobParams& params)
 {
+    m_renderRequested = true;
+
+    if (params.maxSamples > 0)
+        m_maxSamples = params.maxSamples;
+
+    m_scene->startRender(*this, m_maxSamples);
     return MS::kSuccess;
 }
 
 MStatus HypershadeRenderer::stopAsync()
 {
+    m_renderRequested = false;
+    m_scene->stopRender();
     return MS::kSuccess;
 }
 
 bool HypershadeRenderer::isRunningAsync()
 {
-    return true;
+    return m_scene->isRendering();
 }
 
 MStatus HypershadeRenderer::beginSceneUpdate()
 {
+    // The scene can't be edited while appleseed renders it.
+    m_scene->stopRender();
     return MS::kSuccess;
 }
 
 MStatus HypershadeRenderer::endSceneUpdate()
 {
+    m_scene->commit();
+
+    if (m_renderRequested)
+        m_scene->startRender(*this, m_maxSamples);
+
     return MS::kSuccess;
 }
 
 MStatus HypershadeRenderer::destroyScene()
 {
+    m_renderRequested = false;
+    m_scene->clear();
     return MS::kSuccess;
 }
 
@@ -87,6 +803,9 @@ MStatus HypershadeRenderer::setProperty(const MUuid& id, const MString& name, in
 
 MStatus HypershadeRenderer::setProperty(const MUuid& id, const MString& name, float value)
 {
+    if (name == "intensity")
+        m_scene->setLightIntensity(id, value);
+
     return MS::kSuccess;
 }
 
@@ -97,41 +816,48 @@ MStatus HypershadeRenderer::setProperty(const MUuid& id, const MString& name, co
 
 MStatus HypershadeRenderer::setShader(const MUuid& id, const MUuid& shaderId)
 {
+    m_scene->setShader(id, shaderId);
     return MS::kSuccess;
 }
 
 MStatus HypershadeRenderer::setResolution(unsigned int w, unsigned int h)
 {
+    m_scene->setResolution(w, h);
     return MS::kSuccess;
 }
 
-
 MStatus HypershadeRenderer::translateMesh(const MUuid& id, const MObject& node)
 {
+    m_scene->translateMesh(id, node);
     return MS::kSuccess;
 }
 
 MStatus HypershadeRenderer::translateLightSource(const MUuid& id, const MObject& node)
 {
+    m_scene->translateLight(id, node);
     return MS::kSuccess;
 }
 
 MStatus HypershadeRenderer::translateCamera(const MUuid& id, const MObject& node)
 {
+    m_scene->translateCamera(id, node);
     return MS::kSuccess;
 }
 
 MStatus HypershadeRenderer::translateEnvironment(const MUuid& id, EnvironmentType type)
 {
+    m_scene->translateEnvironment();
     return MS::kSuccess;
 }
 
 MStatus HypershadeRenderer::translateTransform(const MUuid& id, const MUuid& childId, const MMatrix& matrix)
 {
+    m_scene->translateTransform(id, childId, matrix);
     return MS::kSuccess;
 }
 
 MStatus HypershadeRenderer::translateShader(const MUuid& id, const MObject& node)
 {
+    m_scene->translateShader(id, node);
     return MS::kSuccess;
 }
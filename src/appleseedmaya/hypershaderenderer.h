@@ -33,6 +33,20 @@
 #include <maya/MPxRenderer.h>
 #include "appleseedmaya/_endmayaheaders.h"
 
+// Standard headers.
+#include <memory>
+
+// Forward declarations.
+class HypershadeScene;
+
+//
+// Hypershade renderer.
+//
+//  Keeps a persistent appleseed project, updated incrementally as Maya
+//  pushes scene deltas, and renders it progressively in a background thread
+//  into the Hypershade material viewer.
+//
+
 class HypershadeRenderer
   : public MPxRenderer
 {
@@ -42,6 +56,7 @@ class HypershadeRenderer
     static void* creator();
 
     HypershadeRenderer();
+    ~HypershadeRenderer() override;
 
     bool isSafeToUnload() override;
 
@@ -67,5 +82,10 @@ class HypershadeRenderer
     MStatus translateEnvironment(const MUuid& id, EnvironmentType type) override;
     MStatus translateTransform(const MUuid& id, const MUuid& childId, const MMatrix& matrix) override;
     MStatus translateShader(const MUuid& id, const MObject& node) override;
+
+  private:
+    std::unique_ptr<HypershadeScene>    m_scene;
+    bool                                m_renderRequested;
+    unsigned int                        m_maxSamples;
 };
 
@@ -54,6 +54,9 @@ namespace Logger
 
 namespace
 {
+    // Minimum category of the messages shown for the current thread.
+    thread_local asf::LogMessage::Category gThreadLogLevel = asf::LogMessage::Debug;
+
     class LogTarget
       : public asf::ILogTarget
     {
@@ -70,6 +73,9 @@ namespace
             const char*                      header,
             const char*                      message)
         {
+            if (category < gThreadLogLevel)
+                return;
+
             const MString prefix("appleseed: ");
 
             switch (category)
@@ -138,6 +144,17 @@ ScopedSetLoggerVerbosity::~ScopedSetLoggerVerbosity()
     asr::global_logger().set_verbosity_level(m_prevLevel);
 }
 
+ScopedSetThreadLogVerbosity::ScopedSetThreadLogVerbosity(foundation::LogMessage::Category newLevel)
+{
+    m_prevLevel = Logger::gThreadLogLevel;
+    Logger::gThreadLogLevel = newLevel;
+}
+
+ScopedSetThreadLogVerbosity::~ScopedSetThreadLogVerbosity()
+{
+    Logger::gThreadLogLevel = m_prevLevel;
+}
+
 ScopedLogTarget::ScopedLogTarget()
 {
 }
@@ -66,6 +66,23 @@ class ScopedSetLoggerVerbosity
     foundation::LogMessage::Category m_prevLevel;
 };
 
+//
+// RAII class to set / restore the minimum category of the messages shown
+// in Maya, for the messages logged from the calling thread only.
+// Unlike ScopedSetLoggerVerbosity, it can be used from worker threads.
+//
+
+class ScopedSetThreadLogVerbosity
+  : public foundation::NonCopyable
+{
+  public:
+    explicit ScopedSetThreadLogVerbosity(foundation::LogMessage::Category newLevel);
+    ~ScopedSetThreadLogVerbosity();
+
+  private:
+    foundation::LogMessage::Category m_prevLevel;
+};
+
 //
 // Helper class to manage appleseed log targets in an exception safe way.
 //
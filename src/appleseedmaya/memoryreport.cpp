@@ -0,0 +1,347 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "memoryreport.h"
+
+// appleseed-maya headers.
+#include "appleseedmaya/utils.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/log.h"
+#include "renderer/api/object.h"
+#include "renderer/api/shadergroup.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/containers/dictionary.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace bfs = boost::filesystem;
+namespace asf = foundation;
+namespace asr = renderer;
+
+namespace
+{
+    std::size_t fileSize(const char* filename)
+    {
+        boost::system::error_code ec;
+        const bfs::path path(filename);
+
+        if (!bfs::is_regular_file(path, ec))
+            return 0;
+
+        const boost::uintmax_t size = bfs::file_size(path, ec);
+        return ec ? 0 : static_cast<std::size_t>(size);
+    }
+
+    std::size_t dictionaryBytes(const asf::Dictionary& dictionary, MemoryUsage& usage)
+    {
+        std::size_t bytes = 0;
+
+        for (auto it = dictionary.strings().begin(), e = dictionary.strings().end(); it != e; ++it)
+        {
+            const char* value = it.value();
+            bytes += std::strlen(it.key()) + std::strlen(value) + 2;
+
+            // Shader parameters are stored as "type value".
+            // Record the files they reference, most likely textures.
+            const char* path = std::strchr(value, ' ');
+            if (path && (std::strchr(path, '/') || std::strchr(path, '\\')))
+                addTextureFileMemoryUsage(path + 1, usage);
+        }
+
+        for (auto it = dictionary.dictionaries().begin(), e = dictionary.dictionaries().end(); it != e; ++it)
+            bytes += std::strlen(it.key()) + 1 + dictionaryBytes(it.value(), usage);
+
+        return bytes;
+    }
+
+    void logBytes(const char* label, const std::size_t bytes)
+    {
+        RENDERER_LOG_INFO(
+            "  %-48s %12.3f MB",
+            label,
+            static_cast<double>(bytes) / (1024.0 * 1024.0));
+    }
+
+    void writeBytesMap(std::ostream& os, const std::map<std::string, std::size_t>& bytes)
+    {
+        os << "{";
+
+        for (auto it = bytes.begin(), e = bytes.end(); it != e; ++it)
+        {
+            if (it != bytes.begin())
+                os << ", ";
+
+            writeJSONString(os, it->first);
+            os << ": " << it->second;
+        }
+
+        os << "}";
+    }
+}
+
+//
+// MemoryUsage class implementation.
+//
+
+void MemoryUsage::add(const char* entityType, const std::size_t bytes)
+{
+    if (bytes == 0)
+        return;
+
+    for (Entry& entry : m_entries)
+    {
+        if (std::strcmp(entry.first, entityType) == 0)
+        {
+            entry.second += bytes;
+            return;
+        }
+    }
+
+    m_entries.emplace_back(entityType, bytes);
+}
+
+void MemoryUsage::addFile(const char* entityType, const char* filename)
+{
+    m_files.emplace_back(entityType, filename);
+}
+
+std::size_t MemoryUsage::totalBytes() const
+{
+    std::size_t bytes = 0;
+
+    for (const Entry& entry : m_entries)
+        bytes += entry.second;
+
+    return bytes;
+}
+
+const std::vector<MemoryUsage::Entry>& MemoryUsage::entries() const
+{
+    return m_entries;
+}
+
+const std::vector<std::pair<const char*, std::string>>& MemoryUsage::files() const
+{
+    return m_files;
+}
+
+void addMeshObjectMemoryUsage(
+    const asr::MeshObject&          mesh,
+    MemoryUsage&                    usage)
+{
+    const std::size_t vertexCount = mesh.get_vertex_count();
+    const std::size_t normalCount = mesh.get_vertex_normal_count();
+    const std::size_t tangentCount = mesh.get_vertex_tangent_count();
+
+    usage.add("mesh vertices", vertexCount * sizeof(asr::GVector3));
+    usage.add("mesh normals", normalCount * sizeof(asr::GVector3));
+    usage.add("mesh tangents", tangentCount * sizeof(asr::GVector3));
+    usage.add("mesh uvs", mesh.get_tex_coords_count() * sizeof(asr::GVector2));
+    usage.add("mesh triangles", mesh.get_triangle_count() * sizeof(asr::Triangle));
+    usage.add(
+        "mesh motion poses",
+        mesh.get_motion_segment_count() * (vertexCount + normalCount + tangentCount) * sizeof(asr::GVector3));
+}
+
+void addShaderGroupMemoryUsage(
+    const asr::ShaderGroup&         shaderGroup,
+    MemoryUsage&                    usage)
+{
+    std::size_t bytes = 0;
+
+    for (const asr::Shader& shader : shaderGroup.shaders())
+        bytes += sizeof(asr::Shader) + dictionaryBytes(shader.get_parameters(), usage);
+
+    bytes += shaderGroup.shader_connections().size() * sizeof(asr::ShaderConnection);
+
+    usage.add("shader groups", bytes);
+}
+
+void addTextureFileMemoryUsage(
+    const char*                     filename,
+    MemoryUsage&                    usage)
+{
+    usage.addFile("texture files", filename);
+}
+
+//
+// MemoryReport class implementation.
+//
+
+MemoryReport::MemoryReport()
+  : m_totalBytes(0)
+{
+}
+
+void MemoryReport::add(
+    const std::string&  nodeType,
+    const std::string&  nodeName,
+    const MemoryUsage&  usage)
+{
+    MemoryUsage nodeUsage = usage;
+
+    for (const auto& file : usage.files())
+    {
+        if (m_files.insert(file.second).second)
+            nodeUsage.add(file.first, fileSize(file.second.c_str()));
+    }
+
+    const std::size_t bytes = nodeUsage.totalBytes();
+
+    if (bytes == 0)
+        return;
+
+    for (const MemoryUsage::Entry& entry : nodeUsage.entries())
+        m_entityTypeBytes[entry.first] += entry.second;
+
+    m_nodeTypeBytes[nodeType] += bytes;
+    m_totalBytes += bytes;
+
+    NodeUsage node;
+    node.m_nodeType = nodeType;
+    node.m_nodeName = nodeName;
+    node.m_usage = nodeUsage;
+    node.m_bytes = bytes;
+    m_nodes.push_back(node);
+}
+
+std::size_t MemoryReport::totalBytes() const
+{
+    return m_totalBytes;
+}
+
+void MemoryReport::logSummary(const std::size_t maxNodes) const
+{
+    RENDERER_LOG_INFO("Scene memory usage:");
+    logBytes("total", m_totalBytes);
+
+    RENDERER_LOG_INFO("Per entity type:");
+    for (auto it = m_entityTypeBytes.begin(), e = m_entityTypeBytes.end(); it != e; ++it)
+        logBytes(it->first.c_str(), it->second);
+
+    RENDERER_LOG_INFO("Per node type:");
+    for (auto it = m_nodeTypeBytes.begin(), e = m_nodeTypeBytes.end(); it != e; ++it)
+        logBytes(it->first.c_str(), it->second);
+
+    RENDERER_LOG_INFO("Heaviest nodes:");
+    for (const NodeUsage* node : heaviestNodes(maxNodes))
+        logBytes(node->m_nodeName.c_str(), node->m_bytes);
+}
+
+bool MemoryReport::writeJSON(const std::string& filename, const std::size_t maxNodes) const
+{
+    std::ofstream file(filename.c_str());
+
+    if (!file.is_open())
+    {
+        RENDERER_LOG_ERROR("Could not open memory report file %s", filename.c_str());
+        return false;
+    }
+
+    file << "{\n";
+    file << "    \"total_bytes\": " << m_totalBytes << ",\n";
+
+    file << "    \"entity_types\": ";
+    writeBytesMap(file, m_entityTypeBytes);
+    file << ",\n";
+
+    file << "    \"node_types\": ";
+    writeBytesMap(file, m_nodeTypeBytes);
+    file << ",\n";
+
+    file << "    \"heaviest_nodes\": [";
+
+    const std::vector<const NodeUsage*> nodes = heaviestNodes(maxNodes);
+
+    for (std::size_t i = 0, e = nodes.size(); i < e; ++i)
+    {
+        const NodeUsage& node = *nodes[i];
+
+        file << (i == 0 ? "\n" : ",\n") << "        {\"name\": ";
+        writeJSONString(file, node.m_nodeName);
+        file << ", \"type\": ";
+        writeJSONString(file, node.m_nodeType);
+        file << ", \"bytes\": " << node.m_bytes << ", \"entities\": {";
+
+        const std::vector<MemoryUsage::Entry>& entries = node.m_usage.entries();
+
+        for (std::size_t j = 0, je = entries.size(); j < je; ++j)
+        {
+            if (j != 0)
+                file << ", ";
+
+            writeJSONString(file, entries[j].first);
+            file << ": " << entries[j].second;
+        }
+
+        file << "}}";
+    }
+
+    file << "\n    ]\n}\n";
+
+    if (!file)
+    {
+        RENDERER_LOG_ERROR("Could not write memory report file %s", filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<const MemoryReport::NodeUsage*> MemoryReport::heaviestNodes(const std::size_t maxNodes) const
+{
+    std::vector<const NodeUsage*> nodes;
+    nodes.reserve(m_nodes.size());
+
+    for (const NodeUsage& node : m_nodes)
+        nodes.push_back(&node);
+
+    const std::size_t count = std::min(maxNodes, nodes.size());
+
+    std::partial_sort(
+        nodes.begin(),
+        nodes.begin() + count,
+        nodes.end(),
+        [](const NodeUsage* a, const NodeUsage* b)
+        {
+            return a->m_bytes > b->m_bytes;
+        });
+
+    nodes.resize(count);
+    return nodes;
+}
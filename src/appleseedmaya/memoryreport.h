@@ -0,0 +1,132 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// Build options header.
+#include "foundation/core/buildoptions.h"
+
+// Standard headers.
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Forward declarations.
+namespace foundation { class Dictionary; }
+namespace renderer { class MeshObject; }
+namespace renderer { class ShaderGroup; }
+
+//
+// MemoryUsage.
+//
+//  Bytes used by the appleseed entities created by an exporter, per entity type,
+//  and files loaded by the renderer (textures), sized once per session by MemoryReport.
+//
+
+class MemoryUsage
+{
+  public:
+    typedef std::pair<const char*, std::size_t> Entry;
+
+    void add(const char* entityType, const std::size_t bytes);
+
+    void addFile(const char* entityType, const char* filename);
+
+    std::size_t totalBytes() const;
+
+    const std::vector<Entry>& entries() const;
+    const std::vector<std::pair<const char*, std::string>>& files() const;
+
+  private:
+    std::vector<Entry>                                  m_entries;
+    std::vector<std::pair<const char*, std::string>>    m_files;
+};
+
+// Add the vertices, normals, tangents, UVs, triangles and motion poses of a mesh.
+void addMeshObjectMemoryUsage(
+    const renderer::MeshObject&     mesh,
+    MemoryUsage&                    usage);
+
+// Add the parameters and connections of a shader group, and the files
+// referenced by its string parameters (textures).
+void addShaderGroupMemoryUsage(
+    const renderer::ShaderGroup&    shaderGroup,
+    MemoryUsage&                    usage);
+
+// Add a texture file.
+void addTextureFileMemoryUsage(
+    const char*                     filename,
+    MemoryUsage&                    usage);
+
+//
+// MemoryReport.
+//
+//  Aggregates the memory usage of all the exporters of a session,
+//  per entity type and per exporter (node) type.
+//
+
+class MemoryReport
+{
+  public:
+    MemoryReport();
+
+    // Add the memory used by a node. Files are sized on disk
+    // and attributed to the first node referencing them.
+    void add(
+        const std::string&  nodeType,
+        const std::string&  nodeName,
+        const MemoryUsage&  usage);
+
+    std::size_t totalBytes() const;
+
+    // Log the totals and the heaviest nodes.
+    void logSummary(const std::size_t maxNodes) const;
+
+    // Write the totals and the heaviest nodes as JSON.
+    bool writeJSON(const std::string& filename, const std::size_t maxNodes) const;
+
+  private:
+    struct NodeUsage
+    {
+        std::string     m_nodeType;
+        std::string     m_nodeName;
+        MemoryUsage     m_usage;
+        std::size_t     m_bytes;
+    };
+
+    std::vector<const NodeUsage*> heaviestNodes(const std::size_t maxNodes) const;
+
+    std::map<std::string, std::size_t>  m_entityTypeBytes;
+    std::map<std::string, std::size_t>  m_nodeTypeBytes;
+    std::vector<NodeUsage>              m_nodes;
+    std::set<std::string>               m_files;
+    std::size_t                         m_totalBytes;
+};
@@ -0,0 +1,85 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// Interface header.
+#include "meshutils.h"
+
+// appleseed-maya headers.
+#include "appleseedmaya/geometryconversion.h"
+
+// Maya headers.
+#include "appleseedmaya/_beginmayaheaders.h"
+#include <maya/MFloatArray.h>
+#include "appleseedmaya/_endmayaheaders.h"
+
+// Standard headers.
+#include <cstring>
+
+namespace asr = renderer;
+
+namespace MeshUtils
+{
+
+static_assert(
+    sizeof(asr::GVector3) == 3 * sizeof(float) && sizeof(asr::GVector2) == 2 * sizeof(float),
+    "Mesh vectors must be tightly packed floats");
+
+const int* intArrayData(MIntArray& array)
+{
+    return array.length() != 0 ? &array[0] : nullptr;
+}
+
+void copyPoints(const MFnMesh& meshFn, std::vector<asr::GVector3>& points)
+{
+    points.resize(meshFn.numVertices());
+    if (!points.empty())
+        std::memcpy(&points[0], meshFn.getRawPoints(nullptr), points.size() * sizeof(asr::GVector3));
+}
+
+void copyUVs(const MFnMesh& meshFn, std::vector<asr::GVector2>& uvs)
+{
+    MFloatArray u, v;
+    meshFn.getUVs(u, v);
+
+    uvs.resize(u.length());
+    if (!uvs.empty())
+        interleaveUVs(&u[0], &v[0], uvs.size(), reinterpret_cast<float*>(&uvs[0]));
+}
+
+void copyNormals(const MFnMesh& meshFn, std::vector<asr::GVector3>& normals)
+{
+    normals.resize(meshFn.numNormals());
+    if (!normals.empty())
+    {
+        normalizeVectors(
+            meshFn.getRawNormals(nullptr),
+            normals.size(),
+            reinterpret_cast<float*>(&normals[0]));
+    }
+}
+
+} // MeshUtils.
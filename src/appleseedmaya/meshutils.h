@@ -0,0 +1,64 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#pragma once
+
+// appleseed.renderer headers.
+#include "renderer/api/object.h"
+
+// Maya headers.
+#include "appleseedmaya/_beginmayaheaders.h"
+#include <maya/MFnMesh.h>
+#include <maya/MIntArray.h>
+#include "appleseedmaya/_endmayaheaders.h"
+
+// Standard headers.
+#include <vector>
+
+//
+// Maya mesh access helpers.
+//
+//  Bulk copies of Maya mesh arrays to appleseed vectors, shared by the
+//  mesh exporter and the Hypershade renderer.
+//
+
+namespace MeshUtils
+{
+
+// Pointer to the contents of an int array, or nullptr if it is empty.
+const int* intArrayData(MIntArray& array);
+
+// Copy the vertices of a mesh.
+void copyPoints(const MFnMesh& meshFn, std::vector<renderer::GVector3>& points);
+
+// Copy the UVs of the current UV set of a mesh.
+void copyUVs(const MFnMesh& meshFn, std::vector<renderer::GVector2>& uvs);
+
+// Copy and normalize the normals of a mesh.
+void copyNormals(const MFnMesh& meshFn, std::vector<renderer::GVector3>& normals);
+
+} // MeshUtils.
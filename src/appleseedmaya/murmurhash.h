@@ -72,6 +72,16 @@ class MurmurHash
 
     std::string toString() const;
 
+    uint64_t h1() const
+    {
+        return m_h1;
+    }
+
+    uint64_t h2() const
+    {
+        return m_h2;
+    }
+
     template <typename T>
     void append(const T& x)
     {
@@ -0,0 +1,62 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "nodemap.h"
+
+// Maya headers.
+#include "appleseedmaya/_beginmayaheaders.h"
+#include <maya/MDagPathArray.h>
+#include <maya/MFn.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MString.h>
+#include "appleseedmaya/_endmayaheaders.h"
+
+void getNodeTypeAndName(const NodeKey& key, std::string& type, std::string& name)
+{
+    if (!key.m_handle.isValid())
+    {
+        type = "unknown";
+        name = "<deleted node>";
+        return;
+    }
+
+    const MObject object = key.m_handle.object();
+    MFnDependencyNode depNodeFn(object);
+    type = depNodeFn.typeName().asChar();
+    name = depNodeFn.name().asChar();
+
+    if (object.hasFn(MFn::kDagNode))
+    {
+        MDagPathArray paths;
+        MDagPath::getAllPathsTo(object, paths);
+
+        if (key.m_instanceNumber < paths.length())
+            name = paths[key.m_instanceNumber].partialPathName().asChar();
+    }
+}
@@ -0,0 +1,211 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// Maya headers.
+#include "appleseedmaya/_beginmayaheaders.h"
+#include <maya/MDagPath.h>
+#include <maya/MObject.h>
+#include <maya/MObjectHandle.h>
+#include "appleseedmaya/_endmayaheaders.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+//
+// NodeKey.
+//
+//  Identifies a Maya node, and for dag nodes one of its instances,
+//  without building path or node name strings.
+//
+
+struct NodeKey
+{
+    NodeKey()
+      : m_instanceNumber(0)
+    {
+    }
+
+    explicit NodeKey(const MObject& node, const unsigned int instanceNumber = 0)
+      : m_handle(node)
+      , m_instanceNumber(instanceNumber)
+    {
+    }
+
+    explicit NodeKey(const MDagPath& path)
+      : m_handle(path.node())
+      , m_instanceNumber(path.isInstanced() ? path.instanceNumber() : 0)
+    {
+    }
+
+    std::size_t hash() const
+    {
+        std::uint64_t h = static_cast<std::uint64_t>(m_handle.hashCode());
+        h ^= static_cast<std::uint64_t>(m_instanceNumber) << 32;
+
+        // Finalizer from MurmurHash3, spreads the bits over the whole word.
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return static_cast<std::size_t>(h);
+    }
+
+    bool operator==(const NodeKey& other) const
+    {
+        return m_instanceNumber == other.m_instanceNumber && m_handle == other.m_handle;
+    }
+
+    MObjectHandle   m_handle;
+    unsigned int    m_instanceNumber;
+};
+
+//
+// NodeMap.
+//
+//  Open addressing hash table from NodeKey to values.
+//  Entries are stored contiguously and iterated in insertion order,
+//  which keeps exports deterministic across sessions.
+//
+
+template <typename T>
+class NodeMap
+{
+  public:
+    typedef std::pair<NodeKey, T>                               value_type;
+    typedef typename std::vector<value_type>::iterator          iterator;
+    typedef typename std::vector<value_type>::const_iterator    const_iterator;
+
+    NodeMap()
+      : m_mask(0)
+    {
+    }
+
+    iterator begin()                { return m_entries.begin(); }
+    iterator end()                  { return m_entries.end(); }
+    const_iterator begin() const    { return m_entries.begin(); }
+    const_iterator end() const      { return m_entries.end(); }
+
+    std::size_t size() const        { return m_entries.size(); }
+    bool empty() const              { return m_entries.empty(); }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_slots.clear();
+        m_mask = 0;
+    }
+
+    void reserve(const std::size_t count)
+    {
+        m_entries.reserve(count);
+
+        if (count * 2 > m_slots.size())
+            rehash(count * 2);
+    }
+
+    iterator find(const NodeKey& key)
+    {
+        if (m_entries.empty())
+            return end();
+
+        const std::size_t slot = findSlot(key);
+        return m_slots[slot] == 0 ? end() : m_entries.begin() + (m_slots[slot] - 1);
+    }
+
+    bool contains(const NodeKey& key)
+    {
+        return find(key) != end();
+    }
+
+    // Insert or replace the value associated with key.
+    void set(const NodeKey& key, const T& value)
+    {
+        // Keep the load factor at or below 1/2.
+        if ((m_entries.size() + 1) * 2 > m_slots.size())
+            rehash((m_entries.size() + 1) * 2);
+
+        const std::size_t slot = findSlot(key);
+
+        if (m_slots[slot] != 0)
+            m_entries[m_slots[slot] - 1].second = value;
+        else
+        {
+            m_entries.emplace_back(key, value);
+            m_slots[slot] = static_cast<std::uint32_t>(m_entries.size());
+        }
+    }
+
+  private:
+    std::vector<value_type>     m_entries;
+    std::vector<std::uint32_t>  m_slots;    // index + 1 into m_entries, 0 for empty slots
+    std::size_t                 m_mask;
+
+    std::size_t findSlot(const NodeKey& key) const
+    {
+        assert(!m_slots.empty());
+
+        std::size_t slot = key.hash() & m_mask;
+
+        while (m_slots[slot] != 0 && !(m_entries[m_slots[slot] - 1].first == key))
+            slot = (slot + 1) & m_mask;
+
+        return slot;
+    }
+
+    void rehash(const std::size_t minSlotCount)
+    {
+        std::size_t slotCount = 16;
+        while (slotCount < minSlotCount)
+            slotCount *= 2;
+
+        m_slots.assign(slotCount, 0);
+        m_mask = slotCount - 1;
+
+        for (std::size_t i = 0, e = m_entries.size(); i < e; ++i)
+        {
+            std::size_t slot = m_entries[i].first.hash() & m_mask;
+
+            while (m_slots[slot] != 0)
+                slot = (slot + 1) & m_mask;
+
+            m_slots[slot] = static_cast<std::uint32_t>(i + 1);
+        }
+    }
+};
+
+// Return the type and name of the node identified by key.
+// Names of dag nodes are partial paths.
+void getNodeTypeAndName(const NodeKey& key, std::string& type, std::string& name);
@@ -0,0 +1,160 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "pixelconversion.h"
+
+// appleseed-maya headers.
+#include "appleseedmaya/kernelconfig.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef APPLESEED_MAYA_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Linear to sRGB lookup table, indexed by the linear value quantized
+    // to LinearToSRGBTableBits bits. 12 bits keep the dark end of the sRGB
+    // curve within one 8 bit code of the exact transfer function.
+    const size_t LinearToSRGBTableBits = 12;
+    const size_t LinearToSRGBTableSize = size_t(1) << LinearToSRGBTableBits;
+    const float LinearToSRGBTableScale = static_cast<float>(LinearToSRGBTableSize - 1);
+
+    struct LinearToSRGBTable
+    {
+        LinearToSRGBTable()
+        {
+            for (size_t i = 0; i < LinearToSRGBTableSize; ++i)
+            {
+                const float linear = static_cast<float>(i) / LinearToSRGBTableScale;
+                const float srgb = linear <= 0.0031308f
+                    ? linear * 12.92f
+                    : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+                m_values[i] = static_cast<std::uint8_t>(std::min(std::max(srgb, 0.0f), 1.0f) * 255.0f + 0.5f);
+            }
+        }
+
+        std::uint8_t m_values[LinearToSRGBTableSize];
+    };
+
+    const LinearToSRGBTable& linearToSRGBTable()
+    {
+        static const LinearToSRGBTable table;
+        return table;
+    }
+
+    size_t quantizeLinear(const float c)
+    {
+        // Also maps NaNs to zero.
+        const float x = c > 0.0f ? (c < 1.0f ? c : 1.0f) : 0.0f;
+        return static_cast<size_t>(x * LinearToSRGBTableScale + 0.5f);
+    }
+}
+
+void convertLinearRGBAToSRGB8BGRAScalar(
+    const float*    src,
+    const size_t    pixelCount,
+    std::uint8_t*   dst)
+{
+    const std::uint8_t* table = linearToSRGBTable().m_values;
+
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        *dst++ = table[quantizeLinear(src[2])];
+        *dst++ = table[quantizeLinear(src[1])];
+        *dst++ = table[quantizeLinear(src[0])];
+        *dst++ = 255;
+        src += 4;
+    }
+}
+
+void convertLinearRGBAToSRGB8BGRA(
+    const float*    src,
+    const size_t    pixelCount,
+    std::uint8_t*   dst)
+{
+#ifdef APPLESEED_MAYA_USE_SSE
+    const std::uint8_t* table = linearToSRGBTable().m_values;
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(LinearToSRGBTableScale);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    // Clamp and quantize a whole pixel at a time, then look up the table.
+    // _mm_max_ps returns its second operand for NaNs, so they map to zero.
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        const __m128 c = _mm_loadu_ps(src);
+        const __m128 clamped = _mm_min_ps(_mm_max_ps(c, zero), one);
+        const __m128i index = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, scale), half));
+
+        alignas(16) std::int32_t indices[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(indices), index);
+
+        dst[0] = table[indices[2]];
+        dst[1] = table[indices[1]];
+        dst[2] = table[indices[0]];
+        dst[3] = 255;
+
+        src += 4;
+        dst += 4;
+    }
+#else
+    convertLinearRGBAToSRGB8BGRAScalar(src, pixelCount, dst);
+#endif
+}
+
+void copyFloatRGBA(
+    const float*    src,
+    const size_t    pixelCount,
+    float*          dst)
+{
+    std::memcpy(dst, src, pixelCount * 4 * sizeof(float));
+}
+
+void copyFloatRGBAFlipped(
+    const float*    src,
+    const size_t    srcRowStride,
+    const size_t    width,
+    const size_t    height,
+    float*          dst)
+{
+    for (size_t y = 0; y < height; ++y)
+    {
+        copyFloatRGBA(
+            src + (height - 1 - y) * srcRowStride * 4,
+            width,
+            dst + y * width * 4);
+    }
+}
@@ -0,0 +1,70 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+
+//
+// Pixel conversion kernels.
+//
+//  Conversions from appleseed float RGBA tile rows to the pixel formats
+//  used by Maya swatches and the render view.
+//
+
+// Convert a row of linear float RGBA pixels to 8 bit sRGB BGRA,
+// the layout used by Maya swatch images. Alpha is set to opaque.
+void convertLinearRGBAToSRGB8BGRA(
+    const float*    src,
+    const size_t    pixelCount,
+    std::uint8_t*   dst);
+
+// Scalar reference version of convertLinearRGBAToSRGB8BGRA.
+void convertLinearRGBAToSRGB8BGRAScalar(
+    const float*    src,
+    const size_t    pixelCount,
+    std::uint8_t*   dst);
+
+// Copy a row of float RGBA pixels, for example to Maya render view RV_PIXELs.
+// The render view applies its own view transform, so values are copied as is.
+void copyFloatRGBA(
+    const float*    src,
+    const size_t    pixelCount,
+    float*          dst);
+
+// Copy a width x height block of float RGBA pixels, flipping it vertically
+// (Maya's render view is y up). srcRowStride is the distance between two
+// rows of src, in pixels. dst is tightly packed.
+void copyFloatRGBAFlipped(
+    const float*    src,
+    const size_t    srcRowStride,
+    const size_t    width,
+    const size_t    height,
+    float*          dst);
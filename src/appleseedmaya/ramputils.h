@@ -5,7 +5,7 @@
 //
 // This software is released under the MIT license.
 //
-// Copyright (c) 2019 Esteban Tovagliari, The appleseedhq Organization
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
 //
 // Permission is hereby granted, free of charge, to any person obtaining a copy
 // of this software and associated documentation files (the "Software"), to deal
@@ -28,6 +28,9 @@
 
 #pragma once
 
+// appleseed-maya headers.
+#include "appleseedmaya/rampserialization.h"
+
 // Maya headers.
 #include "appleseedmaya/_beginmayaheaders.h"
 #include <maya/MColor.h>
@@ -37,27 +40,18 @@
 
 // Standard headers.
 #include <sstream>
-#include <string>
-#include <vector>
 
-template <typename T>
-struct RampEntry
+template <> struct RampValueTraits<MColor>
 {
-    RampEntry(int index, float pos, const T& value)
-      : m_index(index)
-      , m_pos(pos)
-      , m_value(value)
+    static const char* paramValueTypeName()
     {
+        return "color[]";
     }
 
-    bool operator<(const RampEntry<T>& other) const
+    static void outputValue(std::stringstream& ss, const MColor& value)
     {
-        return m_pos < other.m_pos;
+        ss << value.r << " " << value.g << " " << value.b << " ";
     }
-
-    int     m_index;
-    float   m_pos;
-    T       m_value;
 };
 
 template <typename T> struct RampEntryTraits {};
@@ -65,52 +59,9 @@ template <typename T> struct RampEntryTraits {};
 template <> struct RampEntryTraits<MColor>
 {
     typedef MColorArray ArrayType;
-
-    static const char* paramValueTypeName()
-    {
-        return "color[]";
-    }
-
-    static void outputValue(std::stringstream& ss, const MColor& value)
-    {
-        ss << value.r << " " << value.g << " " << value.b << " ";
-    }
 };
 
 template <> struct RampEntryTraits<float>
 {
     typedef MFloatArray ArrayType;
-
-    static const char* paramValueTypeName()
-    {
-        return "float[]";
-    }
-
-    static void outputValue(std::stringstream& ss, const float& value)
-    {
-        ss << value << " ";
-    }
 };
-
-template <typename T>
-void serializeRamp(
-    const std::vector<RampEntry<T>>& entries,
-    std::string&                     outValues,
-    std::string&                     outPositions)
-{
-    std::stringstream ssp;
-    ssp << "float[] ";
-
-    std::stringstream ssv;
-    ssv << RampEntryTraits<T>::paramValueTypeName() << " ";
-
-    for (size_t i = 0, e = entries.size(); i < e; ++i)
-    {
-        ssp << entries[i].m_pos << " ";
-        RampEntryTraits<T>::outputValue(ssv, entries[i].m_value);
-    }
-
-    outValues = ssv.str();
-    outPositions = ssp.str();
-}
-
@@ -180,6 +180,8 @@ MObject RenderGlobalsNode::m_renderStampString;
 
 MObject RenderGlobalsNode::m_logLevel;
 MObject RenderGlobalsNode::m_logFilename;
+MObject RenderGlobalsNode::m_profileExport;
+MObject RenderGlobalsNode::m_profileFilename;
 
 namespace
 {
@@ -707,6 +709,15 @@ MStatus RenderGlobalsNode::initialize()
     typedAttrFn.setUsedAsFilename(true);
     CHECKED_ADD_ATTRIBUTE(m_logFilename, "logFilename")
 
+    // Export profiling.
+    m_profileExport = numAttrFn.create("profileExport", "profileExport", MFnNumericData::kBoolean, false, &status);
+    CHECKED_ADD_ATTRIBUTE(m_profileExport, "profileExport")
+
+    // Export profile trace filename.
+    m_profileFilename = typedAttrFn.create("profileFilename", "profileFilename", MFnData::kString, &status);
+    typedAttrFn.setUsedAsFilename(true);
+    CHECKED_ADD_ATTRIBUTE(m_profileFilename, "profileFilename")
+
     #undef CHECKED_ADD_ATTRIBUTE
 
     return status;
@@ -1300,3 +1311,18 @@ MString RenderGlobalsNode::logFilename(const MObject& globals)
     AttributeUtils::get(MPlug(globals, m_logFilename), filename);
     return filename;
 }
+
+// Export profiling.
+bool RenderGlobalsNode::profileExport(const MObject& globals)
+{
+    bool enabled = false;
+    AttributeUtils::get(MPlug(globals, m_profileExport), enabled);
+    return enabled;
+}
+
+MString RenderGlobalsNode::profileFilename(const MObject& globals)
+{
+    MString filename;
+    AttributeUtils::get(MPlug(globals, m_profileFilename), filename);
+    return filename;
+}
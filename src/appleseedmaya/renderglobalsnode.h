@@ -78,6 +78,9 @@ class RenderGlobalsNode
     static foundation::LogMessage::Category logLevel(const MObject& globals);
     static MString logFilename(const MObject& globals);
 
+    static bool profileExport(const MObject& globals);
+    static MString profileFilename(const MObject& globals);
+
   private:
     static MObject      m_passes;
 
@@ -210,5 +213,9 @@ class RenderGlobalsNode
     // Logging.
     static MObject      m_logLevel;
     static MObject      m_logFilename;
+
+    // Profiling.
+    static MObject      m_profileExport;
+    static MObject      m_profileFilename;
 };
 
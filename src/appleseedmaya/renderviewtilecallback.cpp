@@ -31,6 +31,7 @@
 
 // appleseed-maya headers.
 #include "appleseedmaya/idlejobqueue.h"
+#include "appleseedmaya/pixelconversion.h"
 #include "appleseedmaya/utils.h"
 
 // Build options header.
@@ -297,20 +298,15 @@ namespace
             RV_PIXEL* p = pixels.get();
 
             // Copy and flip the tile verticaly (Maya's renderview is y up).
-            for (int j = ymax; j >= ymin; --j)
-            {
-                size_t y = j - y0;
-
-                for (int i = xmin; i <= xmax; ++i)
-                {
-                    const size_t x = i - x0;
-                    p->r = tile.get_component<float>(x, y, 0);
-                    p->g = tile.get_component<float>(x, y, 1);
-                    p->b = tile.get_component<float>(x, y, 2);
-                    p->a = tile.get_component<float>(x, y, 3);
-                    p++;
-                }
-            }
+            // RV_PIXEL has the same layout as the tile pixels, copy whole rows.
+            static_assert(sizeof(RV_PIXEL) == 4 * sizeof(float), "Unexpected RV_PIXEL layout");
+
+            copyFloatRGBAFlipped(
+                reinterpret_cast<const float*>(tile.pixel(xmin - x0, ymin - y0)),
+                tile.get_width(),
+                w,
+                h,
+                reinterpret_cast<float*>(p));
 
             flip_pixel_interval(displayWindowHeight(), ymin, ymax);
             WriteTileToRenderView tileJob(xmin, ymin, xmax, ymax, pixels, m_rendererController, m_computation);
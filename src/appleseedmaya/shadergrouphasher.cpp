@@ -0,0 +1,211 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "shadergrouphasher.h"
+
+// appleseed-maya headers.
+#include "appleseedmaya/exportprofiler.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/shadergroup.h"
+
+// Standard headers.
+#include <algorithm>
+#include <map>
+#include <string>
+
+namespace asr = renderer;
+
+namespace
+{
+    // Hashing is cheap, a few threads are enough to keep up with the export.
+    const size_t MaxWorkerCount = 4;
+
+    typedef std::map<std::string, size_t> LayerIndices;
+
+    void appendLayer(MurmurHash& hash, const LayerIndices& layers, const char* layer)
+    {
+        const auto it = layers.find(layer);
+        if (it != layers.end())
+            hash.append(it->second);
+        else
+            hash.append(layer);
+    }
+}
+
+MurmurHash shaderGroupStructureHash(const asr::ShaderGroup& shaderGroup)
+{
+    MurmurHash hash;
+    LayerIndices layers;
+
+    for (const asr::Shader& shader : shaderGroup.shaders())
+    {
+        const size_t index = layers.size();
+        layers[shader.get_layer()] = index;
+
+        hash.append(shader.get_type());
+        hash.append(shader.get_shader());
+        hash.append(shader.get_parameters());
+    }
+
+    for (const asr::ShaderConnection& connection : shaderGroup.shader_connections())
+    {
+        appendLayer(hash, layers, connection.get_src_layer());
+        hash.append(connection.get_src_param());
+        appendLayer(hash, layers, connection.get_dst_layer());
+        hash.append(connection.get_dst_param());
+    }
+
+    return hash;
+}
+
+ShaderGroupHasher::ShaderGroupHasher(ExportProfiler& profiler)
+  : m_profiler(profiler)
+  , m_pendingCount(0)
+  , m_stop(false)
+{
+}
+
+ShaderGroupHasher::~ShaderGroupHasher()
+{
+    cancel();
+}
+
+size_t ShaderGroupHasher::submit(const asr::ShaderGroup& shaderGroup)
+{
+    size_t index;
+    size_t pendingCount;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        index = m_hashes.size();
+        m_hashes.push_back(MurmurHash());
+
+        Job job;
+        job.m_shaderGroup = &shaderGroup;
+        job.m_index = index;
+        m_jobs.push_back(job);
+        pendingCount = ++m_pendingCount;
+    }
+
+    // Workers are started on demand, up to one per core.
+    const size_t maxWorkers = std::min<size_t>(
+        MaxWorkerCount,
+        std::max(std::thread::hardware_concurrency(), 1u));
+
+    if (m_workers.size() < maxWorkers && m_workers.size() < pendingCount)
+        m_workers.push_back(std::thread(&ShaderGroupHasher::run, this));
+    else
+        m_jobAvailable.notify_one();
+
+    return index;
+}
+
+void ShaderGroupHasher::wait()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_jobsDone.wait(lock, [this]() { return m_pendingCount == 0; });
+    }
+
+    stopWorkers();
+}
+
+void ShaderGroupHasher::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingCount -= m_jobs.size();
+        m_jobs.clear();
+    }
+
+    stopWorkers();
+}
+
+const std::vector<MurmurHash>& ShaderGroupHasher::hashes() const
+{
+    return m_hashes;
+}
+
+void ShaderGroupHasher::run()
+{
+    std::string name;
+
+    while (true)
+    {
+        Job job;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobAvailable.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+
+            if (m_jobs.empty())
+                return;
+
+            job = m_jobs.front();
+            m_jobs.pop_front();
+        }
+
+        const std::uint64_t start = m_profiler.isEnabled() ? m_profiler.now() : 0;
+        const MurmurHash hash = shaderGroupStructureHash(*job.m_shaderGroup);
+
+        if (m_profiler.isEnabled())
+        {
+            name = job.m_shaderGroup->get_name();
+            m_profiler.addEvent("hashShaderGroup", "shaderGroup", name, start, m_profiler.now());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_hashes[job.m_index] = hash;
+
+            if (--m_pendingCount == 0)
+                m_jobsDone.notify_all();
+        }
+    }
+}
+
+void ShaderGroupHasher::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_jobAvailable.notify_all();
+
+    for (std::thread& worker : m_workers)
+        worker.join();
+
+    m_workers.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = false;
+}
@@ -0,0 +1,104 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed-maya headers.
+#include "appleseedmaya/murmurhash.h"
+
+// Build options header.
+#include "foundation/core/buildoptions.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Standard headers.
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Forward declarations.
+class ExportProfiler;
+namespace renderer { class ShaderGroup; }
+
+// Hash the shaders, parameters and connections of a shader group.
+// Layer names are not hashed, so that identical networks of different
+// Maya nodes get the same hash.
+MurmurHash shaderGroupStructureHash(const renderer::ShaderGroup& shaderGroup);
+
+//
+// ShaderGroupHasher.
+//
+//  Hashes shader groups on worker threads while the export continues.
+//  Shader groups must not be modified until wait() or cancel() returns.
+//
+
+class ShaderGroupHasher
+  : public foundation::NonCopyable
+{
+  public:
+    explicit ShaderGroupHasher(ExportProfiler& profiler);
+
+    // Cancels pending work.
+    ~ShaderGroupHasher();
+
+    // Queue a shader group, and return the index of its hash.
+    size_t submit(const renderer::ShaderGroup& shaderGroup);
+
+    // Wait until all the queued shader groups are hashed.
+    void wait();
+
+    // Drop the shader groups not hashed yet, and stop the worker threads.
+    void cancel();
+
+    // Hashes, in submission order. Only valid after wait().
+    const std::vector<MurmurHash>& hashes() const;
+
+  private:
+    struct Job
+    {
+        const renderer::ShaderGroup*    m_shaderGroup;
+        size_t                          m_index;
+    };
+
+    void run();
+    void stopWorkers();
+
+    ExportProfiler&             m_profiler;
+    std::mutex                  m_mutex;
+    std::condition_variable     m_jobAvailable;
+    std::condition_variable     m_jobsDone;
+    std::deque<Job>             m_jobs;
+    size_t                      m_pendingCount;
+    bool                        m_stop;
+    std::vector<MurmurHash>     m_hashes;
+    std::vector<std::thread>    m_workers;
+};
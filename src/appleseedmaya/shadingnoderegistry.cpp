@@ -120,6 +120,9 @@ namespace
     typedef std::map<MString, OSLShaderInfo, MStringCompareLess> OSLShaderInfoMap;
     OSLShaderInfoMap gShadersInfo;
 
+    // Paths of the .oso files found, by shader filename without extension.
+    std::map<std::string, bfs::path> gShaderFilePaths;
+
     bool doRegisterShader(
         const bfs::path&    shaderPath,
         MFnPlugin&          pluginFn,
@@ -259,6 +262,10 @@ namespace
                                 "Found OSL shader %s.",
                                 shaderPath.string().c_str());
 
+                            // Like shading nodes, the first shader found wins.
+                            gShaderFilePaths.insert(
+                                std::make_pair(shaderPath.stem().string(), shaderPath));
+
                             registerShader(shaderPath, pluginFn, query);
                         }
                     }
@@ -369,4 +376,14 @@ bool isShaderSupported(const MString& nodeName)
     return getShaderInfo(nodeName) != nullptr;
 }
 
+std::string getShaderFilePath(const char* shaderFileName)
+{
+    auto it = gShaderFilePaths.find(shaderFileName);
+
+    if (it == gShaderFilePaths.end())
+        return std::string();
+
+    return it->second.string();
+}
+
 } // namespace ShadingNodeRegistry
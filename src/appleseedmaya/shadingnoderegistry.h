@@ -36,6 +36,9 @@
 #include <maya/MStringArray.h>
 #include "appleseedmaya/_endmayaheaders.h"
 
+// Standard headers.
+#include <string>
+
 // Forward declarations.
 class OSLShaderInfo;
 
@@ -60,5 +63,9 @@ namespace ShadingNodeRegistry
 
     // Return true if a shading node is supported (is registered).
     bool isShaderSupported(const MString& nodeName);
+
+    // Return the path of the .oso file found for a shader while registering
+    // shading nodes, or an empty string if there is none.
+    std::string getShaderFilePath(const char* shaderFileName);
 } // namespace ShadingNodeRegistry
 
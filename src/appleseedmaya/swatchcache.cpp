@@ -0,0 +1,303 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "swatchcache.h"
+
+// appleseed-maya headers.
+#include "appleseedmaya/logger.h"
+#include "appleseedmaya/shadingnoderegistry.h"
+
+// Build options header.
+#include "foundation/core/buildoptions.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/shadergroup.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+
+// Standard headers.
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <string>
+
+namespace bfs = boost::filesystem;
+namespace asr = renderer;
+
+namespace
+{
+    const char* SwatchFileMagic = "ASMSWCH1";
+    const size_t SwatchFileMagicSize = 8;
+
+    // Append the modification time of a file to a hash, if the file exists.
+    void appendLastWriteTime(MurmurHash& hash, const bfs::path& path)
+    {
+        boost::system::error_code ec;
+        const std::time_t time = bfs::last_write_time(path, ec);
+
+        if (!ec)
+            hash.append(static_cast<std::int64_t>(time));
+    }
+
+    // Shader parameters are stored as "type value".
+    // Hash the modification times of the files they reference.
+    void appendReferencedFiles(MurmurHash& hash, const asr::ParamArray& params)
+    {
+        for (auto it = params.strings().begin(), e = params.strings().end(); it != e; ++it)
+        {
+            const char* value = it.value();
+            const char* path = std::strchr(value, ' ');
+
+            if (path && (std::strchr(path, '/') || std::strchr(path, '\\')))
+                appendLastWriteTime(hash, bfs::path(path + 1));
+        }
+    }
+}
+
+MurmurHash computeSwatchHash(
+    const asr::ShaderGroup&     shaderGroup,
+    const int                   swatchKind,
+    const size_t                resolution,
+    const size_t                samples)
+{
+    MurmurHash hash;
+    hash.append(swatchKind);
+    hash.append(resolution);
+    hash.append(samples);
+
+    // Assign an index to each layer, in evaluation order.
+    std::map<std::string, size_t> layerIndices;
+
+    const asr::ShaderContainer& shaders = shaderGroup.shaders();
+    for (size_t i = 0, e = shaders.size(); i < e; ++i)
+    {
+        const asr::Shader* shader = shaders.get_by_index(i);
+        layerIndices[shader->get_layer()] = i;
+
+        hash.append(shader->get_type());
+        hash.append(shader->get_shader());
+        hash.append(shader->get_parameters());
+
+        const std::string shaderFilePath =
+            ShadingNodeRegistry::getShaderFilePath(shader->get_shader());
+        if (!shaderFilePath.empty())
+            appendLastWriteTime(hash, bfs::path(shaderFilePath));
+
+        appendReferencedFiles(hash, shader->get_parameters());
+    }
+
+    const asr::ShaderConnectionContainer& connections = shaderGroup.shader_connections();
+    for (size_t i = 0, e = connections.size(); i < e; ++i)
+    {
+        const asr::ShaderConnection* c = connections.get_by_index(i);
+        hash.append(layerIndices[c->get_src_layer()]);
+        hash.append(c->get_src_param());
+        hash.append(layerIndices[c->get_dst_layer()]);
+        hash.append(c->get_dst_param());
+    }
+
+    return hash;
+}
+
+SwatchCache::SwatchCache(const size_t maxMemorySize)
+  : m_maxMemorySize(maxMemorySize)
+  , m_memorySize(0)
+{
+}
+
+void SwatchCache::setDiskCachePath(const bfs::path& path)
+{
+    m_diskCachePath.clear();
+
+    if (path.empty())
+        return;
+
+    try
+    {
+        if (!bfs::exists(path))
+            bfs::create_directories(path);
+
+        m_diskCachePath = path;
+        RENDERER_LOG_INFO("Using swatch disk cache %s.", path.string().c_str());
+    }
+    catch (const bfs::filesystem_error& e)
+    {
+        RENDERER_LOG_WARNING(
+            "Could not create swatch disk cache directory %s, error = %s.",
+            path.string().c_str(),
+            e.what());
+    }
+}
+
+bool SwatchCache::get(const MurmurHash& key, std::vector<std::uint8_t>& pixels)
+{
+    auto it = m_index.find(key);
+
+    if (it != m_index.end())
+    {
+        // Move the entry to the front of the list.
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        pixels = it->second->second;
+        return true;
+    }
+
+    if (readFromDisk(key, pixels))
+    {
+        insertInMemory(key, pixels);
+        return true;
+    }
+
+    return false;
+}
+
+void SwatchCache::insert(const MurmurHash& key, const std::vector<std::uint8_t>& pixels)
+{
+    insertInMemory(key, pixels);
+    writeToDisk(key, pixels);
+}
+
+void SwatchCache::clear()
+{
+    m_entries.clear();
+    m_index.clear();
+    m_memorySize = 0;
+}
+
+void SwatchCache::insertInMemory(const MurmurHash& key, const std::vector<std::uint8_t>& pixels)
+{
+    auto it = m_index.find(key);
+
+    if (it != m_index.end())
+    {
+        m_memorySize -= it->second->second.size();
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+
+    m_entries.push_front(Entry(key, pixels));
+    m_index[key] = m_entries.begin();
+    m_memorySize += pixels.size();
+
+    evict();
+}
+
+void SwatchCache::evict()
+{
+    // Always keep the most recently used entry.
+    while (m_memorySize > m_maxMemorySize && m_entries.size() > 1)
+    {
+        const Entry& last = m_entries.back();
+        m_memorySize -= last.second.size();
+        m_index.erase(last.first);
+        m_entries.pop_back();
+    }
+}
+
+bool SwatchCache::readFromDisk(const MurmurHash& key, std::vector<std::uint8_t>& pixels) const
+{
+    if (m_diskCachePath.empty())
+        return false;
+
+    const bfs::path filename = diskCacheFilename(key);
+
+    boost::system::error_code ec;
+    const boost::uintmax_t fileSize = bfs::file_size(filename, ec);
+    if (ec || fileSize < SwatchFileMagicSize + sizeof(std::uint64_t))
+        return false;
+
+    std::ifstream ifs(filename.string().c_str(), std::ios::in | std::ios::binary);
+    if (!ifs)
+        return false;
+
+    char magic[SwatchFileMagicSize];
+    std::uint64_t size = 0;
+
+    ifs.read(magic, SwatchFileMagicSize);
+    ifs.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+    if (!ifs || std::memcmp(magic, SwatchFileMagic, SwatchFileMagicSize) != 0)
+        return false;
+
+    // Do not trust the size stored in the file.
+    if (size != fileSize - SwatchFileMagicSize - sizeof(std::uint64_t))
+        return false;
+
+    pixels.resize(static_cast<size_t>(size));
+    ifs.read(reinterpret_cast<char*>(pixels.data()), pixels.size());
+
+    return static_cast<bool>(ifs);
+}
+
+void SwatchCache::writeToDisk(const MurmurHash& key, const std::vector<std::uint8_t>& pixels) const
+{
+    if (m_diskCachePath.empty())
+        return;
+
+    // Write to a uniquely named temporary file first, so that other Maya
+    // sessions sharing the cache never read a partial file.
+    const bfs::path filename = diskCacheFilename(key);
+
+    boost::system::error_code ec;
+    const bfs::path tmpFilename = bfs::unique_path(filename.string() + ".%%%%-%%%%.tmp", ec);
+
+    bool succeeded = false;
+
+    if (!ec)
+    {
+        std::ofstream ofs(tmpFilename.string().c_str(), std::ios::out | std::ios::binary);
+
+        const std::uint64_t size = pixels.size();
+        ofs.write(SwatchFileMagic, SwatchFileMagicSize);
+        ofs.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        ofs.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+        ofs.close();
+
+        if (ofs)
+        {
+            bfs::rename(tmpFilename, filename, ec);
+            succeeded = !ec;
+        }
+
+        if (!succeeded)
+            bfs::remove(tmpFilename, ec);
+    }
+
+    if (!succeeded)
+    {
+        RENDERER_LOG_WARNING(
+            "Could not write swatch cache file %s.",
+            filename.string().c_str());
+    }
+}
+
+bfs::path SwatchCache::diskCacheFilename(const MurmurHash& key) const
+{
+    return m_diskCachePath / (key.toString() + ".swatch");
+}
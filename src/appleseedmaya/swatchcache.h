@@ -0,0 +1,109 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// appleseed-maya headers.
+#include "appleseedmaya/murmurhash.h"
+
+// Build options header.
+#include "foundation/core/buildoptions.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Boost headers.
+#include "boost/filesystem/path.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <vector>
+
+// Forward declarations.
+namespace renderer { class ShaderGroup; }
+
+//
+// Hash of an exported swatch shading network.
+//
+//  Layer names are replaced by their position in the shader group,
+//  so that identical networks made of differently named nodes share
+//  the same hash. The modification times of the .oso files of the
+//  shaders and of the files referenced by their parameters, most likely
+//  textures, are included, as well as the swatch quality settings.
+//
+
+MurmurHash computeSwatchHash(
+    const renderer::ShaderGroup&    shaderGroup,
+    const int                       swatchKind,
+    const size_t                    resolution,
+    const size_t                    samples);
+
+//
+// SwatchCache.
+//
+//  LRU cache of 8 bit BGRA swatch images, with an optional on disk cache.
+//  Not thread safe, it is meant to be used from Maya's main thread.
+//
+
+class SwatchCache
+  : public foundation::NonCopyable
+{
+  public:
+    explicit SwatchCache(const size_t maxMemorySize);
+
+    // Enable the on disk cache. An empty path disables it.
+    void setDiskCachePath(const boost::filesystem::path& path);
+
+    // Lookup a swatch in the memory cache first, then in the disk cache.
+    bool get(const MurmurHash& key, std::vector<std::uint8_t>& pixels);
+
+    // Insert a swatch in the memory cache and the disk cache.
+    void insert(const MurmurHash& key, const std::vector<std::uint8_t>& pixels);
+
+    void clear();
+
+  private:
+    typedef std::pair<MurmurHash, std::vector<std::uint8_t>>  Entry;
+    typedef std::list<Entry>                                  EntryList;
+
+    void insertInMemory(const MurmurHash& key, const std::vector<std::uint8_t>& pixels);
+    void evict();
+
+    bool readFromDisk(const MurmurHash& key, std::vector<std::uint8_t>& pixels) const;
+    void writeToDisk(const MurmurHash& key, const std::vector<std::uint8_t>& pixels) const;
+    boost::filesystem::path diskCacheFilename(const MurmurHash& key) const;
+
+    const size_t                                    m_maxMemorySize;
+    size_t                                          m_memorySize;
+    EntryList                                       m_entries;
+    std::map<MurmurHash, EntryList::iterator>       m_index;
+    boost::filesystem::path                         m_diskCachePath;
+};
@@ -32,6 +32,9 @@
 // appleseed-maya headers.
 #include "appleseedmaya/appleseedsession.h"
 #include "appleseedmaya/logger.h"
+#include "appleseedmaya/murmurhash.h"
+#include "appleseedmaya/pixelconversion.h"
+#include "appleseedmaya/swatchcache.h"
 #include "appleseedmaya/utils.h"
 
 // Build options header.
@@ -49,6 +52,7 @@
 #include "renderer/api/project.h"
 #include "renderer/api/rendering.h"
 #include "renderer/api/scene.h"
+#include "renderer/api/shadergroup.h"
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
@@ -63,14 +67,26 @@
 
 // Maya headers.
 #include "appleseedmaya/_beginmayaheaders.h"
+#include <maya/MDGMessage.h>
 #include <maya/MFnDependencyNode.h>
 #include <maya/MImage.h>
+#include <maya/MObjectHandle.h>
 #include <maya/MPlug.h>
 #include "appleseedmaya/_endmayaheaders.h"
 
 // Standard headers.
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace asf = foundation;
 namespace asr = renderer;
@@ -188,11 +204,6 @@ namespace
             m_project.reset();
         }
 
-        asr::Project& getProject()
-        {
-            return *m_project;
-        }
-
         void createMaterialSceneGeometry()
         {
             // Create the light.
@@ -257,34 +268,25 @@ namespace
             m_mainAssembly->object_instances().insert(objInstance);
         }
 
-        void render(const size_t resolution, MImage& dstImage)
-        {
-            // Disable logging while rendering the swatch.
-            ScopedSetLoggerVerbosity logLevel(asf::LogMessage::Error);
+        bool render(SwatchJob& job);
 
-            // Recreate the frame.
+      private:
+        void setFrameResolution(const size_t resolution)
+        {
             asr::ParamArray frameParams = m_project->get_frame()->get_parameters();
             frameParams.insert("resolution", asf::Vector2u(resolution, resolution));
             asf::auto_release_ptr<asr::Frame> frame(asr::FrameFactory::create("beauty", frameParams));
             m_project->set_frame(frame);
-
-            // Render.
-            m_renderer->render(m_rendererController);
-            copySwatchImage(dstImage);
         }
 
-      private:
-        static uint8_t to_uint8(const float c)
-        {
-            return static_cast<uint8_t>(asf::saturate(c) * 255.0f);
-        }
-
-        void copySwatchImage(MImage& dstImage) const
+        void copySwatchImage(std::vector<uint8_t>& dstPixels) const
         {
             const asf::Image& srcImage = m_project->get_frame()->image();
             const asf::CanvasProperties& props = srcImage.properties();
             size_t width = props.m_canvas_width;
 
+            dstPixels.resize(props.m_canvas_width * props.m_canvas_height * 4);
+
             for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
             {
                 for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
@@ -295,23 +297,20 @@ namespace
                     const size_t y0 = props.m_tile_height * ty;
 
                     const asf::Tile& tile = srcImage.tile(tx, ty);
-                    const float* src = reinterpret_cast<const float*>(tile.get_storage());
+                    assert(tile.get_pixel_format() == asf::PixelFormatFloat);
+                    assert(tile.get_channel_count() == 4);
+
+                    // Edge tiles can extend past the canvas.
+                    const size_t w = std::min(tile.get_width(), props.m_canvas_width - x0);
+                    const size_t h = std::min(tile.get_height(), props.m_canvas_height - y0);
 
-                    for (size_t j = 0, je = tile.get_height(); j < je; ++j)
+                    for (size_t j = 0; j < h; ++j)
                     {
                         // For swatches, we assume 4 8 bit channels.
-                        const size_t y = y0 + j;
-                        uint8_t* dst = dstImage.pixels() + (y * width * 4) + (x0 * 4);
-
-                        for (size_t i = 0, ie = tile.get_width(); i < ie; ++i)
-                        {
-                            // Maya docs say RGBA, but it is actually BGRA.
-                            *dst++ = to_uint8(src[2]);
-                            *dst++ = to_uint8(src[1]);
-                            *dst++ = to_uint8(src[0]);
-                            *dst++ = 255;
-                            src += 4;
-                        }
+                        // Maya docs say RGBA, but it is actually BGRA.
+                        const float* src = reinterpret_cast<const float*>(tile.pixel(0, j));
+                        uint8_t* dst = dstPixels.data() + ((y0 + j) * width * 4) + (x0 * 4);
+                        convertLinearRGBAToSRGB8BGRA(src, w, dst);
                     }
                 }
             }
@@ -321,12 +320,398 @@ namespace
         asr::Assembly*                       m_mainAssembly;
         asr::Material*                       m_material;
         std::unique_ptr<asr::MasterRenderer> m_renderer;
-        asr::DefaultRendererController       m_rendererController;
     };
+}
+
+//
+// A swatch render request.
+//
+//  Jobs are created in the main thread, with the shading network already
+//  exported, and rendered by the swatch render queue worker thread.
+//
+
+class SwatchJob
+  : public asf::NonCopyable
+{
+  public:
+    enum Kind
+    {
+        MaterialSwatch,
+        TextureSwatch
+    };
+
+    SwatchJob(
+        const Kind                                  kind,
+        const unsigned int                          nodeKey,
+        const size_t                                resolution,
+        const MurmurHash&                           hash,
+        asf::auto_release_ptr<asr::ShaderGroup>     shaderGroup)
+      : m_kind(kind)
+      , m_nodeKey(nodeKey)
+      , m_resolution(resolution)
+      , m_hash(hash)
+      , m_shaderGroup(shaderGroup)
+      , m_samples(4)
+      , m_threadCount(1)
+      , m_cancelled(false)
+      , m_done(false)
+      , m_succeeded(false)
+      , m_waiterCount(0)
+    {
+    }
+
+    void cancel()
+    {
+        m_cancelled = true;
+    }
+
+    // Cancel the job because a newer job renders the same swatch.
+    // Called from the main thread.
+    void supersede(const std::shared_ptr<SwatchJob>& successor)
+    {
+        m_successor = successor;
+        cancel();
+    }
+
+    // The job that replaced this one, if any. Called from the main thread.
+    const std::shared_ptr<SwatchJob>& successor() const
+    {
+        return m_successor;
+    }
+
+    // Register a swatch renderer waiting for the job.
+    // Called from the main thread.
+    void addWaiter()
+    {
+        ++m_waiterCount;
+    }
+
+    // Cancel the job when no swatch renderer waits for it anymore.
+    // Called from the main thread.
+    void removeWaiter()
+    {
+        assert(m_waiterCount > 0);
+
+        if (--m_waiterCount == 0)
+            cancel();
+    }
+
+    bool isCancelled() const
+    {
+        return m_cancelled;
+    }
+
+    bool isDone() const
+    {
+        return m_done;
+    }
+
+    void setDone(const bool succeeded)
+    {
+        m_succeeded = succeeded;
+        m_done = true;
+    }
+
+    // Only valid once the job is done.
+    bool succeeded() const
+    {
+        return m_succeeded;
+    }
+
+    // Only valid once the job is done.
+    const std::vector<uint8_t>& pixels() const
+    {
+        return m_pixels;
+    }
+
+    // Set the rendered swatch. Called from the worker thread, before setDone.
+    void setPixels(std::vector<uint8_t>& pixels)
+    {
+        m_pixels.swap(pixels);
+    }
+
+    const Kind                                  m_kind;
+    const unsigned int                          m_nodeKey;
+    const size_t                                m_resolution;
+    const MurmurHash                            m_hash;
+    asf::auto_release_ptr<asr::ShaderGroup>     m_shaderGroup;
+
+    // Rendering settings.
+    size_t                                      m_samples;
+    size_t                                      m_threadCount;
+
+  private:
+    std::atomic<bool>                           m_cancelled;
+    std::atomic<bool>                           m_done;
+    bool                                        m_succeeded;
+    std::shared_ptr<SwatchJob>                  m_successor;
+    size_t                                      m_waiterCount;
+    std::vector<uint8_t>                        m_pixels;
+};
+
+namespace
+{
+    typedef std::shared_ptr<SwatchJob> SwatchJobPtr;
+
+    class SwatchRendererController
+      : public asr::DefaultRendererController
+    {
+      public:
+        explicit SwatchRendererController(const SwatchJob& job)
+          : m_job(job)
+        {
+        }
+
+        Status get_status() const override
+        {
+            return m_job.isCancelled() ? AbortRendering : ContinueRendering;
+        }
+
+      private:
+        const SwatchJob& m_job;
+    };
+
+    bool SwatchProject::render(SwatchJob& job)
+    {
+        // Replace the shading network of the swatch material.
+        const std::string shaderGroupName = job.m_shaderGroup->get_name();
+        m_mainAssembly->shader_groups().clear();
+        m_mainAssembly->shader_groups().insert(job.m_shaderGroup);
+        m_material->get_parameters().insert("osl_surface", shaderGroupName.c_str());
+
+        asr::ParamArray& params = m_renderer->get_parameters();
+        params.insert("rendering_threads", job.m_threadCount);
+        params.insert_path("uniform_pixel_renderer.samples", job.m_samples);
+
+        setFrameResolution(job.m_resolution);
+
+        // Render.
+        SwatchRendererController rendererController(job);
+        m_renderer->render(rendererController);
+
+        if (job.isCancelled())
+            return false;
+
+        std::vector<uint8_t> pixels;
+        copySwatchImage(pixels);
+        job.setPixels(pixels);
+        return true;
+    }
+
+    //
+    // Swatch render queue.
+    //
+    //  Renders swatch jobs in a background thread, using its own projects.
+    //  Pending jobs are deduplicated by node and resolution: submitting a job
+    //  supersedes any previous job for the same node and resolution.
+    //
+
+    class SwatchRenderQueue
+      : public asf::NonCopyable
+    {
+      public:
+        SwatchRenderQueue()
+          : m_stop(false)
+        {
+        }
+
+        void start(const asf::SearchPaths& resourceSearchPaths)
+        {
+            {
+                // Disable logging from appleseed.
+                ScopedSetLoggerVerbosity logLevel(asf::LogMessage::Error);
+
+                m_materialSwatchProject.initialize(resourceSearchPaths);
+                m_materialSwatchProject.createMaterialSceneGeometry();
+
+                m_textureSwatchProject.initialize(resourceSearchPaths);
+                m_textureSwatchProject.createTextureSceneGeometry();
+            }
+
+            m_stop = false;
+            std::thread thread(&SwatchRenderQueue::workerFunc, this);
+            m_workerThread.swap(thread);
+        }
+
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+
+                for (auto it = m_pendingJobs.begin(), e = m_pendingJobs.end(); it != e; ++it)
+                {
+                    (*it)->cancel();
+                    (*it)->setDone(false);
+                }
+
+                m_pendingJobs.clear();
+
+                if (m_activeJob)
+                    m_activeJob->cancel();
+            }
+
+            m_condition.notify_one();
+
+            if (m_workerThread.joinable())
+                m_workerThread.join();
+
+            {
+                // Disable logging from appleseed.
+                ScopedSetLoggerVerbosity logLevel(asf::LogMessage::Error);
+
+                m_materialSwatchProject.uninitialize();
+                m_textureSwatchProject.uninitialize();
+            }
+        }
+
+        void submit(const SwatchJobPtr& job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                // Jobs submitted after the worker thread stopped fail at once.
+                if (m_stop)
+                {
+                    job->setDone(false);
+                    return;
+                }
+
+                for (auto it = m_pendingJobs.begin(), e = m_pendingJobs.end(); it != e; ++it)
+                {
+                    if (isSameSwatch(**it, *job))
+                        (*it)->supersede(job);
+                }
+
+                if (m_activeJob && isSameSwatch(*m_activeJob, *job))
+                    m_activeJob->supersede(job);
+
+                m_pendingJobs.push_back(job);
+            }
+
+            m_condition.notify_one();
+        }
+
+        void cancel(const unsigned int nodeKey)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            cancelJobsForNode(nodeKey);
+        }
+
+      private:
+        // Cancelled jobs are skipped, so that they keep their first successor.
+        static bool isSameSwatch(const SwatchJob& lhs, const SwatchJob& rhs)
+        {
+            return
+                !lhs.isCancelled() &&
+                lhs.m_nodeKey == rhs.m_nodeKey &&
+                lhs.m_resolution == rhs.m_resolution;
+        }
+
+        // Must be called with the mutex locked.
+        void cancelJobsForNode(const unsigned int nodeKey)
+        {
+            for (auto it = m_pendingJobs.begin(), e = m_pendingJobs.end(); it != e; ++it)
+            {
+                if ((*it)->m_nodeKey == nodeKey)
+                    (*it)->cancel();
+            }
+
+            if (m_activeJob && m_activeJob->m_nodeKey == nodeKey)
+                m_activeJob->cancel();
+        }
+
+        void workerFunc()
+        {
+            // Only show errors from swatch renders. The global logger verbosity
+            // belongs to the main thread, where render sessions set and restore it.
+            ScopedSetThreadLogVerbosity logLevel(asf::LogMessage::Error);
+
+            while (true)
+            {
+                SwatchJobPtr job;
+
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_condition.wait(lock, [this] { return m_stop || !m_pendingJobs.empty(); });
+
+                    if (m_stop)
+                        break;
+
+                    job = m_pendingJobs.front();
+                    m_pendingJobs.pop_front();
+
+                    if (job->isCancelled())
+                    {
+                        job->setDone(false);
+                        continue;
+                    }
+
+                    m_activeJob = job;
+                }
+
+                SwatchProject& project = job->m_kind == SwatchJob::MaterialSwatch
+                    ? m_materialSwatchProject
+                    : m_textureSwatchProject;
+
+                const bool succeeded = project.render(*job);
+
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_activeJob.reset();
+                }
+
+                job->setDone(succeeded);
+            }
+        }
+
+        SwatchProject               m_materialSwatchProject;
+        SwatchProject               m_textureSwatchProject;
+
+        std::thread                 m_workerThread;
+        std::mutex                  m_mutex;
+        std::condition_variable     m_condition;
+        std::deque<SwatchJobPtr>    m_pendingJobs;
+        SwatchJobPtr                m_activeJob;
+        bool                        m_stop;
+    };
+
+    // Memory budget for cached swatch images.
+    const size_t SwatchCacheMaxMemorySize = 128 * 1024 * 1024;
 
-    SwatchProject       g_materialSwatchProject;
-    SwatchProject       g_textureSwatchProject;
+    // Default number of samples per pixel of swatches.
+    const size_t SwatchDefaultSamples = 4;
+
+    SwatchRenderQueue   g_swatchRenderQueue;
+    SwatchCache         g_swatchCache(SwatchCacheMaxMemorySize);
     asf::SearchPaths    g_resourceSearchPaths;
+    MCallbackId         g_nodeRemovedCallbackId = 0;
+    size_t              g_swatchSamples = SwatchDefaultSamples;
+
+    size_t swatchRenderingThreads()
+    {
+        // A single thread while a render session is running,
+        // to stay out of the way of interactive and final renders.
+        // Otherwise a fixed half of the hardware threads.
+        if (AppleseedSession::sessionMode() != AppleseedSession::NoSession)
+            return 1;
+
+        return std::max<size_t>(1, std::thread::hardware_concurrency() / 2);
+    }
+
+    // Show an empty swatch for networks that cannot be rendered,
+    // so that Maya stops polling the swatch renderer.
+    void clearSwatchImage(MImage& image, const int resolution)
+    {
+        image.create(resolution, resolution);
+        std::memset(image.pixels(), 0, resolution * resolution * 4);
+    }
+
+    void nodeRemovedCallback(MObject& node, void* clientData)
+    {
+        // Cancel swatches for deleted nodes.
+        g_swatchRenderQueue.cancel(MObjectHandle(node).hashCode());
+    }
 }
 
 const MString SwatchRenderer::name("AppleseedRenderSwatch");
@@ -334,30 +719,37 @@ const MString SwatchRenderer::fullName("swatch/AppleseedRenderSwatch");
 
 void SwatchRenderer::initialize(const MString& /*pluginPath*/)
 {
-    {
-        // Disable logging from appleseed.
-        ScopedSetLoggerVerbosity logLevel(asf::LogMessage::Error);
+    g_swatchRenderQueue.start(g_resourceSearchPaths);
 
-        g_materialSwatchProject.initialize(g_resourceSearchPaths);
-        g_materialSwatchProject.createMaterialSceneGeometry();
+    // Optional on disk swatch cache, shared between Maya sessions.
+    if (const char* diskCachePath = getenv("APPLESEED_MAYA_SWATCH_CACHE_PATH"))
+        g_swatchCache.setDiskCachePath(diskCachePath);
 
-        g_textureSwatchProject.initialize(g_resourceSearchPaths);
-        g_textureSwatchProject.createTextureSceneGeometry();
-    }
+    // Swatch quality.
+    if (const char* samples = getenv("APPLESEED_MAYA_SWATCH_SAMPLES"))
+        g_swatchSamples = std::max(1, atoi(samples));
+
+    MStatus status;
+    g_nodeRemovedCallbackId = MDGMessage::addNodeRemovedCallback(
+        &nodeRemovedCallback,
+        "dependNode",
+        nullptr,
+        &status);
 
     RENDERER_LOG_INFO("Initialized swatch renderer.");
 }
 
 void SwatchRenderer::uninitialize()
 {
+    if (g_nodeRemovedCallbackId != 0)
     {
-        // Disable logging from appleseed.
-        ScopedSetLoggerVerbosity logLevel(asf::LogMessage::Error);
-
-        g_materialSwatchProject.uninitialize();
-        g_textureSwatchProject.uninitialize();
+        MMessage::removeCallback(g_nodeRemovedCallbackId);
+        g_nodeRemovedCallbackId = 0;
     }
 
+    g_swatchRenderQueue.stop();
+    g_swatchCache.clear();
+
     RENDERER_LOG_INFO("Uninitialized swatch renderer.");
 }
 
@@ -377,41 +769,112 @@ SwatchRenderer::SwatchRenderer(
 {
 }
 
-bool SwatchRenderer::doIteration()
+SwatchRenderer::~SwatchRenderer()
 {
-    MFnDependencyNode depNodeFn(node());
-    const MString name = depNodeFn.name();
-    const MString typeName = depNodeFn.typeName();
-    const MString classification = MFnDependencyNode::classification(typeName);
-
-    /*
-    RENDERER_LOG_DEBUG(
-        "Rendering swatch for node %s of type %s and classification %s. res = %d",
-        name.asChar(),
-        typeName.asChar(),
-        classification.asChar(),
-        resolution());
-    */
-
-    // Allocate the pixels.
-    image().create(resolution(), resolution());
+    // Maya no longer needs this swatch.
+    if (m_job)
+        m_job->removeWaiter();
+}
 
-    if (strstr(classification.asChar(), "rendernode/appleseed/surface") != nullptr)
+bool SwatchRenderer::doIteration()
+{
+    // Maya calls doIteration from its idle loop until it returns true.
+    // The first call exports the shading network and queues the job,
+    // the following calls poll for the result.
+    if (!m_job)
     {
-        if (AppleseedSession::exportMaterialSwatch(g_materialSwatchProject.getProject(), node()))
+        MFnDependencyNode depNodeFn(node());
+        const MString typeName = depNodeFn.typeName();
+        const MString classification = MFnDependencyNode::classification(typeName);
+
+        SwatchJob::Kind kind;
+        asf::auto_release_ptr<asr::ShaderGroup> shaderGroup;
+
+        if (strstr(classification.asChar(), "rendernode/appleseed/surface") != nullptr)
+        {
+            kind = SwatchJob::MaterialSwatch;
+            shaderGroup = AppleseedSession::exportMaterialSwatch(node());
+        }
+        else if (strstr(classification.asChar(), "rendernode/appleseed/texture") != nullptr)
+        {
+            kind = SwatchJob::TextureSwatch;
+            shaderGroup = AppleseedSession::exportTextureSwatch(node());
+        }
+        else
+        {
+            clearSwatchImage(image(), resolution());
+            return true;
+        }
+
+        if (shaderGroup.get() == nullptr)
+        {
+            clearSwatchImage(image(), resolution());
+            return true;
+        }
+
+        // Return cached swatches for identical networks immediately.
+        const MurmurHash hash = computeSwatchHash(*shaderGroup, kind, resolution(), g_swatchSamples);
+
+        std::vector<uint8_t> pixels;
+        if (g_swatchCache.get(hash, pixels) &&
+            pixels.size() == static_cast<size_t>(resolution() * resolution() * 4))
         {
-            g_materialSwatchProject.render(resolution(), image());
+            image().create(resolution(), resolution());
+            std::memcpy(image().pixels(), pixels.data(), pixels.size());
             return true;
         }
+
+        m_job.reset(
+            new SwatchJob(
+                kind,
+                MObjectHandle(node()).hashCode(),
+                static_cast<size_t>(resolution()),
+                hash,
+                shaderGroup));
+        m_job->m_samples = g_swatchSamples;
+        m_job->m_threadCount = swatchRenderingThreads();
+
+        m_job->addWaiter();
+        g_swatchRenderQueue.submit(m_job);
+        return false;
     }
-    else if (strstr(classification.asChar(), "rendernode/appleseed/texture") != nullptr)
+
+    if (!m_job->isDone())
+        return false;
+
+    if (!m_job->succeeded())
     {
-        AppleseedSession::exportTextureSwatch(g_textureSwatchProject.getProject(), node());
+        // The job was cancelled and its image must not be shown.
+        // If a newer job renders the same swatch, wait for it instead.
+        if (m_job->successor())
         {
-            g_textureSwatchProject.render(resolution(), image());
-            return true;
+            SwatchJobPtr successor = m_job->successor();
+            successor->addWaiter();
+            m_job->removeWaiter();
+            m_job = successor;
+            return false;
         }
+
+        // A job cancelled without successor, for example for a deleted node,
+        // is exported and submitted again on the next call.
+        const bool cancelled = m_job->isCancelled();
+        m_job->removeWaiter();
+        m_job.reset();
+
+        if (cancelled)
+            return false;
+
+        // The render failed, retrying would fail again.
+        clearSwatchImage(image(), resolution());
+        return true;
     }
 
-    return false;
+    // Allocate the pixels and copy the swatch.
+    assert(m_job->pixels().size() == static_cast<size_t>(resolution() * resolution() * 4));
+    image().create(resolution(), resolution());
+    std::memcpy(image().pixels(), m_job->pixels().data(), m_job->pixels().size());
+    g_swatchCache.insert(m_job->m_hash, m_job->pixels());
+
+    m_job.reset();
+    return true;
 }
@@ -33,6 +33,12 @@
 #include <maya/MSwatchRenderBase.h>
 #include "appleseedmaya/_endmayaheaders.h"
 
+// Standard headers.
+#include <memory>
+
+// Forward declarations.
+class SwatchJob;
+
 class SwatchRenderer
   : public MSwatchRenderBase
 {
@@ -48,6 +54,8 @@ class SwatchRenderer
         MObject renderNode,
         int     imageResolution);
 
+    ~SwatchRenderer() override;
+
     bool doIteration() override;
 
   private:
@@ -55,5 +63,7 @@ class SwatchRenderer
         MObject dependNode,
         MObject renderNode,
         int     imageResolution);
+
+    std::shared_ptr<SwatchJob> m_job;
 };
 
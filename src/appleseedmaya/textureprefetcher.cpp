@@ -0,0 +1,125 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "textureprefetcher.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/log.h"
+
+// Standard headers.
+#include <fstream>
+#include <vector>
+
+namespace
+{
+    // Large enough for the header and the first tiles or scanlines of
+    // most texture files, including tiled and mipmapped .tx files.
+    const std::size_t PrefetchBytes = 64 * 1024;
+
+    bool readFileHeader(const std::string& filename, std::vector<char>& buffer)
+    {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+
+        if (!file.is_open())
+            return false;
+
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        return file.gcount() > 0;
+    }
+}
+
+TexturePrefetcher::TexturePrefetcher()
+  : m_stop(false)
+  , m_prefetchedCount(0)
+{
+}
+
+TexturePrefetcher::~TexturePrefetcher()
+{
+    stop();
+}
+
+void TexturePrefetcher::prefetch(const std::string& filename)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_stop || !m_files.insert(filename).second)
+            return;
+
+        m_queue.push_back(filename);
+    }
+
+    // The thread is started with the first file.
+    if (!m_thread.joinable())
+        m_thread = std::thread(&TexturePrefetcher::run, this);
+    else
+        m_condition.notify_one();
+}
+
+void TexturePrefetcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_queue.clear();
+    }
+
+    m_condition.notify_one();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+        RENDERER_LOG_DEBUG("Prefetched %zu texture file headers", m_prefetchedCount);
+    }
+}
+
+void TexturePrefetcher::run()
+{
+    std::vector<char> buffer(PrefetchBytes);
+
+    while (true)
+    {
+        std::string filename;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+
+            if (m_stop)
+                return;
+
+            filename = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        if (readFileHeader(filename, buffer))
+            ++m_prefetchedCount;
+    }
+}
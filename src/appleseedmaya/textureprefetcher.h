@@ -0,0 +1,80 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// Build options header.
+#include "foundation/core/buildoptions.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Standard headers.
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+//
+// TexturePrefetcher.
+//
+//  Reads the headers of texture files in a background thread while the
+//  rest of the scene is exported, so that they are in the OS file cache
+//  when the renderer opens them. This mostly helps with textures stored
+//  on network drives.
+//
+
+class TexturePrefetcher
+  : public foundation::NonCopyable
+{
+  public:
+    TexturePrefetcher();
+
+    // Stops prefetching.
+    ~TexturePrefetcher();
+
+    // Queue a file. Files already queued are ignored.
+    void prefetch(const std::string& filename);
+
+    // Stop prefetching, and wait for the file being read.
+    void stop();
+
+  private:
+    void run();
+
+    std::mutex                  m_mutex;
+    std::condition_variable     m_condition;
+    std::deque<std::string>     m_queue;
+    std::set<std::string>       m_files;
+    bool                        m_stop;
+    std::size_t                 m_prefetchedCount;
+    std::thread                 m_thread;
+};
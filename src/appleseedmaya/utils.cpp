@@ -40,6 +40,10 @@
 #include <maya/MSelectionList.h>
 #include "appleseedmaya/_endmayaheaders.h"
 
+// Standard headers.
+#include <cstdio>
+#include <ostream>
+
 MStatus getDependencyNodeByName(const MString& name, MObject& node)
 {
     MSelectionList selList;
@@ -62,6 +66,36 @@ MStatus getDagPathByName(const MString& name, MDagPath& dag)
     return selList.getDagPath(0, dag);
 }
 
+void writeJSONString(std::ostream& os, const std::string& s)
+{
+    os << '"';
+
+    for (const char c : s)
+    {
+        switch (c)
+        {
+          case '"':  os << "\\\""; break;
+          case '\\': os << "\\\\"; break;
+          case '\n': os << "\\n"; break;
+          case '\r': os << "\\r"; break;
+          case '\t': os << "\\t"; break;
+
+          default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                os << buffer;
+            }
+            else
+                os << c;
+            break;
+        }
+    }
+
+    os << '"';
+}
+
 std::shared_ptr<Computation> Computation::create()
 {
     return std::shared_ptr<Computation>(new Computation());
@@ -47,6 +47,7 @@
 
 // Standard headers.
 #include <cstring>
+#include <iosfwd>
 #include <memory>
 #include <string>
 
@@ -197,6 +198,9 @@ void insertEntityWithUniqueName(
 MStatus getDependencyNodeByName(const MString& name, MObject& object);
 MStatus getDagPathByName(const MString& name, MDagPath& dag);
 
+// Write a quoted and escaped JSON string.
+void writeJSONString(std::ostream& os, const std::string& s);
+
 //
 // Simple wrapper around MComputation
 //
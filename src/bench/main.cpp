@@ -0,0 +1,613 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed-maya headers.
+#include "appleseedmaya/geometryconversion.h"
+#include "appleseedmaya/hashing.h"
+#include "appleseedmaya/pixelconversion.h"
+#include "appleseedmaya/rampserialization.h"
+
+// Standard headers.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//
+// Headless export benchmark.
+//
+//  Runs the data conversion kernels used when exporting scenes and
+//  rendering to Maya on synthetic meshes, shading networks and frames,
+//  and reports their throughput. Results can be saved and compared to a
+//  previous run, in which case the exit code is non zero if a kernel got
+//  slower than the tolerance allows, or if a fast path no longer matches
+//  its scalar reference.
+//
+
+namespace
+{
+
+struct Options
+{
+    Options()
+      : m_repetitions(9)
+      , m_tolerance(0.1)
+    {
+    }
+
+    size_t          m_repetitions;
+    double          m_tolerance;
+    std::string     m_saveFilename;
+    std::string     m_compareFilename;
+};
+
+struct Result
+{
+    std::string     m_name;
+    double          m_items;            // items processed per repetition
+    double          m_bestSeconds;
+    double          m_medianSeconds;
+};
+
+// Run f repeatedly and time it.
+Result measure(
+    const std::string&              name,
+    const double                    items,
+    const size_t                    repetitions,
+    const std::function<void()>&    f)
+{
+    // Warm up caches and thread pools.
+    f();
+
+    std::vector<double> seconds;
+    seconds.reserve(repetitions);
+
+    for (size_t i = 0; i < repetitions; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const auto end = std::chrono::steady_clock::now();
+        seconds.push_back(std::chrono::duration<double>(end - start).count());
+    }
+
+    std::sort(seconds.begin(), seconds.end());
+
+    Result result;
+    result.m_name = name;
+    result.m_items = items;
+    result.m_bestSeconds = seconds.front();
+    result.m_medianSeconds = seconds[seconds.size() / 2];
+    return result;
+}
+
+double itemsPerSecond(const Result& result)
+{
+    return result.m_items / std::max(result.m_medianSeconds, 1.0e-9);
+}
+
+// Keep the optimizer from discarding kernel outputs.
+volatile std::uint64_t g_sink = 0;
+
+template <typename T>
+void consume(const std::vector<T>& v)
+{
+    if (!v.empty())
+    {
+        std::uint64_t x = 0;
+        std::memcpy(&x, v.data(), std::min(sizeof(x), sizeof(T) * v.size()));
+        g_sink = g_sink + x;
+    }
+}
+
+
+//
+// Synthetic data.
+//
+
+// A grid of quads, with the layout returned by MFnMesh.
+struct GridMesh
+{
+    explicit GridMesh(const size_t resolution)
+    {
+        const size_t rowVertices = resolution + 1;
+
+        for (size_t j = 0; j < resolution; ++j)
+        {
+            for (size_t i = 0; i < resolution; ++i)
+            {
+                const int v0 = static_cast<int>(j * rowVertices + i);
+                const int v1 = v0 + 1;
+                const int v2 = v1 + static_cast<int>(rowVertices);
+                const int v3 = v0 + static_cast<int>(rowVertices);
+
+                const int faceVertices[4] = {v0, v1, v2, v3};
+                const int triangleVertices[6] = {v0, v1, v2, v0, v2, v3};
+
+                m_faceVertexCounts.push_back(4);
+                m_faceTriangleCounts.push_back(2);
+                m_faceUVCounts.push_back(4);
+                m_faceMaterials.push_back(static_cast<int>((i / 16) % 4));
+
+                for (size_t k = 0; k < 4; ++k)
+                {
+                    m_faceVertices.push_back(faceVertices[k]);
+                    m_faceUVs.push_back(faceVertices[k]);
+                    m_faceNormals.push_back(static_cast<int>(m_faceNormals.size()));
+                }
+
+                m_triangleVertices.insert(
+                    m_triangleVertices.end(),
+                    triangleVertices,
+                    triangleVertices + 6);
+            }
+        }
+
+        m_topology.m_faceCount = m_faceVertexCounts.size();
+        m_topology.m_faceVertexCounts = m_faceVertexCounts.data();
+        m_topology.m_faceVertices = m_faceVertices.data();
+        m_topology.m_faceTriangleCounts = m_faceTriangleCounts.data();
+        m_topology.m_triangleVertices = m_triangleVertices.data();
+        m_topology.m_faceUVCounts = m_faceUVCounts.data();
+        m_topology.m_faceUVs = m_faceUVs.data();
+        m_topology.m_faceNormals = m_faceNormals.data();
+        m_topology.m_faceMaterials = m_faceMaterials.data();
+    }
+
+    size_t triangleCount() const
+    {
+        return m_triangleVertices.size() / 3;
+    }
+
+    std::vector<int>        m_faceVertexCounts;
+    std::vector<int>        m_faceVertices;
+    std::vector<int>        m_faceTriangleCounts;
+    std::vector<int>        m_triangleVertices;
+    std::vector<int>        m_faceUVCounts;
+    std::vector<int>        m_faceUVs;
+    std::vector<int>        m_faceNormals;
+    std::vector<int>        m_faceMaterials;
+    PolygonMeshTopology     m_topology;
+};
+
+std::vector<float> randomFloats(
+    const size_t    count,
+    const float     minValue,
+    const float     maxValue,
+    const unsigned  seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(minValue, maxValue);
+
+    std::vector<float> values(count);
+    for (size_t i = 0; i < count; ++i)
+        values[i] = dist(rng);
+
+    return values;
+}
+
+
+//
+// Correctness checks.
+//
+
+bool checkNormalizeVectors()
+{
+    const size_t count = 100003;
+    std::vector<float> src = randomFloats(count * 3, -10.0f, 10.0f, 1);
+
+    // A few zero length vectors.
+    std::fill(src.begin(), src.begin() + 3, 0.0f);
+    std::fill(src.end() - 3, src.end(), 0.0f);
+
+    std::vector<float> fast(count * 3);
+    std::vector<float> reference(count * 3);
+    normalizeVectors(src.data(), count, fast.data());
+    normalizeVectorsScalar(src.data(), count, reference.data());
+
+    for (size_t i = 0, e = src.size(); i < e; ++i)
+    {
+        if (std::abs(fast[i] - reference[i]) > 1.0e-5f)
+        {
+            std::fprintf(stderr, "normalizeVectors: mismatch at vector %zu\n", i / 3);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool checkTriangulateFaces()
+{
+    GridMesh mesh(8);
+
+    std::vector<TriangleIndices> triangles;
+    triangulateFaces(mesh.m_topology, triangles);
+
+    if (triangles.size() != mesh.triangleCount())
+    {
+        std::fprintf(stderr, "triangulateFaces: wrong triangle count\n");
+        return false;
+    }
+
+    // Second triangle of the first quad is (v0, v2, v3), face vertices 0, 2 and 3.
+    const TriangleIndices& t = triangles[1];
+    if (t.m_n0 != 0 || t.m_n1 != 2 || t.m_n2 != 3 || t.m_a0 != t.m_v0 || t.m_a2 != t.m_v2)
+    {
+        std::fprintf(stderr, "triangulateFaces: wrong face vertex indices\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool checkFindInstanceMasters()
+{
+    const std::uint64_t hashes[] = {1, 2, 3, 4, 1, 2, 1, 5};
+
+    std::vector<size_t> masters;
+    findInstanceMasters(hashes, 4, masters);
+
+    const size_t expected[] = {0, 1, 0, 3};
+    if (!std::equal(masters.begin(), masters.end(), expected))
+    {
+        std::fprintf(stderr, "findInstanceMasters: wrong masters\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+//
+// Benchmarks.
+//
+
+void runBenchmarks(const Options& options, std::vector<Result>& results)
+{
+    const size_t reps = options.m_repetitions;
+
+    // Mesh export.
+    {
+        const size_t vertexCount = 1000000;
+        const std::vector<float> normals = randomFloats(vertexCount * 3, -1.0f, 1.0f, 3);
+        std::vector<float> dst(vertexCount * 3);
+
+        results.push_back(
+            measure("mesh.normalizeVectors", vertexCount, reps, [&]()
+            {
+                normalizeVectors(normals.data(), vertexCount, dst.data());
+                consume(dst);
+            }));
+
+        results.push_back(
+            measure("mesh.normalizeVectorsScalar", vertexCount, reps, [&]()
+            {
+                normalizeVectorsScalar(normals.data(), vertexCount, dst.data());
+                consume(dst);
+            }));
+
+        const std::vector<float> u = randomFloats(vertexCount, 0.0f, 1.0f, 4);
+        const std::vector<float> v = randomFloats(vertexCount, 0.0f, 1.0f, 5);
+        std::vector<float> uvs(vertexCount * 2);
+
+        results.push_back(
+            measure("mesh.interleaveUVs", vertexCount, reps, [&]()
+            {
+                interleaveUVs(u.data(), v.data(), vertexCount, uvs.data());
+                consume(uvs);
+            }));
+
+        GridMesh mesh(512);
+        std::vector<TriangleIndices> triangles;
+
+        results.push_back(
+            measure("mesh.triangulateFaces", static_cast<double>(mesh.triangleCount()), reps, [&]()
+            {
+                triangulateFaces(mesh.m_topology, triangles);
+                consume(triangles);
+            }));
+    }
+
+    // Instancing detection.
+    {
+        const size_t objectCount = 100000;
+        const size_t uniqueObjectCount = 1000;
+
+        std::vector<std::uint64_t> hashes(objectCount * 2);
+        std::mt19937 rng(6);
+        for (size_t i = 0; i < objectCount; ++i)
+        {
+            std::uint64_t h1 = 0;
+            std::uint64_t h2 = 0;
+            const std::uint64_t id = rng() % uniqueObjectCount;
+            murmurHash3Append(h1, h2, &id, sizeof(id));
+            hashes[2 * i] = h1;
+            hashes[2 * i + 1] = h2;
+        }
+
+        std::vector<size_t> masters;
+
+        results.push_back(
+            measure("instancing.findInstanceMasters", objectCount, reps, [&]()
+            {
+                findInstanceMasters(hashes.data(), objectCount, masters);
+                consume(masters);
+            }));
+
+        // Hashing of mesh sized buffers, in bytes.
+        const std::vector<float> points = randomFloats(1000000 * 3, -1.0f, 1.0f, 7);
+        const size_t bytes = points.size() * sizeof(float);
+
+        results.push_back(
+            measure("instancing.murmurHash3Append", static_cast<double>(bytes), reps, [&]()
+            {
+                std::uint64_t h1 = 0;
+                std::uint64_t h2 = 0;
+                murmurHash3Append(h1, h2, points.data(), bytes);
+                g_sink = g_sink + h1 + h2;
+            }));
+    }
+
+    // Shading networks.
+    {
+        const size_t rampCount = 1000;
+        const size_t rampEntryCount = 16;
+
+        std::vector<std::vector<RampEntry<float>>> ramps(rampCount);
+        const std::vector<float> values = randomFloats(rampCount * rampEntryCount * 2, 0.0f, 1.0f, 8);
+        for (size_t i = 0; i < rampCount; ++i)
+        {
+            for (size_t j = 0; j < rampEntryCount; ++j)
+            {
+                const size_t k = (i * rampEntryCount + j) * 2;
+                ramps[i].push_back(RampEntry<float>(static_cast<int>(j), values[k], values[k + 1]));
+            }
+
+            std::sort(ramps[i].begin(), ramps[i].end());
+        }
+
+        std::string rampValues;
+        std::string rampPositions;
+
+        results.push_back(
+            measure("shading.serializeRamp", rampCount, reps, [&]()
+            {
+                for (size_t i = 0; i < rampCount; ++i)
+                {
+                    serializeRamp(ramps[i], rampValues, rampPositions);
+                    g_sink = g_sink + rampValues.size() + rampPositions.size();
+                }
+            }));
+    }
+
+    // Rendering, a 1920x1080 frame in 64x64 tiles.
+    {
+        const size_t tileSize = 64;
+        const size_t tileCount = (1920 / tileSize) * (1088 / tileSize);
+        const size_t pixelCount = tileSize * tileSize;
+
+        const std::vector<float> tile = randomFloats(pixelCount * 4, 0.0f, 2.0f, 9);
+        std::vector<float> renderViewPixels(pixelCount * 4);
+        std::vector<std::uint8_t> swatchPixels(pixelCount * 4);
+
+        results.push_back(
+            measure("render.copyFloatRGBAFlipped", static_cast<double>(tileCount * pixelCount), reps, [&]()
+            {
+                for (size_t i = 0; i < tileCount; ++i)
+                {
+                    copyFloatRGBAFlipped(tile.data(), tileSize, tileSize, tileSize, renderViewPixels.data());
+                    consume(renderViewPixels);
+                }
+            }));
+
+        results.push_back(
+            measure("render.convertLinearRGBAToSRGB8BGRA", static_cast<double>(tileCount * pixelCount), reps, [&]()
+            {
+                for (size_t i = 0; i < tileCount; ++i)
+                {
+                    convertLinearRGBAToSRGB8BGRA(tile.data(), pixelCount, swatchPixels.data());
+                    consume(swatchPixels);
+                }
+            }));
+
+        results.push_back(
+            measure("render.convertLinearRGBAToSRGB8BGRAScalar", static_cast<double>(tileCount * pixelCount), reps, [&]()
+            {
+                for (size_t i = 0; i < tileCount; ++i)
+                {
+                    convertLinearRGBAToSRGB8BGRAScalar(tile.data(), pixelCount, swatchPixels.data());
+                    consume(swatchPixels);
+                }
+            }));
+    }
+}
+
+
+//
+// Reporting.
+//
+
+void printResults(const std::vector<Result>& results)
+{
+    std::printf("%-44s %12s %12s %16s\n", "kernel", "best (ms)", "median (ms)", "items/s");
+
+    for (const Result& result : results)
+    {
+        std::printf(
+            "%-44s %12.3f %12.3f %16.4g\n",
+            result.m_name.c_str(),
+            result.m_bestSeconds * 1000.0,
+            result.m_medianSeconds * 1000.0,
+            itemsPerSecond(result));
+    }
+}
+
+bool saveResults(const std::string& filename, const std::vector<Result>& results)
+{
+    std::ofstream file(filename.c_str());
+    if (!file.is_open())
+    {
+        std::fprintf(stderr, "Could not open %s for writing\n", filename.c_str());
+        return false;
+    }
+
+    // One kernel per line: name and median items per second.
+    file.precision(9);
+    for (const Result& result : results)
+        file << result.m_name << " " << itemsPerSecond(result) << "\n";
+
+    return true;
+}
+
+bool compareResults(
+    const std::string&          filename,
+    const double                tolerance,
+    const std::vector<Result>&  results)
+{
+    std::ifstream file(filename.c_str());
+    if (!file.is_open())
+    {
+        std::fprintf(stderr, "Could not open %s for reading\n", filename.c_str());
+        return false;
+    }
+
+    std::map<std::string, double> baseline;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream ss(line);
+        std::string name;
+        double value;
+        if (ss >> name >> value)
+            baseline[name] = value;
+    }
+
+    bool success = true;
+
+    std::printf("\n%-44s %16s %16s %9s\n", "kernel", "baseline", "current", "change");
+
+    for (const Result& result : results)
+    {
+        const auto it = baseline.find(result.m_name);
+        if (it == baseline.end())
+            continue;
+
+        const double current = itemsPerSecond(result);
+        const double change = current / it->second - 1.0;
+        const bool regressed = change < -tolerance;
+
+        std::printf(
+            "%-44s %16.4g %16.4g %+8.1f%%%s\n",
+            result.m_name.c_str(),
+            it->second,
+            current,
+            change * 100.0,
+            regressed ? "  REGRESSION" : "");
+
+        if (regressed)
+            success = false;
+    }
+
+    return success;
+}
+
+void printUsage(const char* program)
+{
+    std::printf(
+        "Usage: %s [options]\n"
+        "  --repetitions N      Number of timed runs of each kernel (default: 9)\n"
+        "  --save FILE          Save the results to FILE\n"
+        "  --compare FILE       Compare the results to the ones saved in FILE\n"
+        "  --tolerance X        Allowed slowdown when comparing, as a fraction (default: 0.1)\n",
+        program);
+}
+
+bool parseArguments(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--repetitions" && hasValue)
+            options.m_repetitions = std::max(std::strtoul(argv[++i], nullptr, 10), 1ul);
+        else if (arg == "--save" && hasValue)
+            options.m_saveFilename = argv[++i];
+        else if (arg == "--compare" && hasValue)
+            options.m_compareFilename = argv[++i];
+        else if (arg == "--tolerance" && hasValue)
+            options.m_tolerance = std::atof(argv[++i]);
+        else
+            return false;
+    }
+
+    return true;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseArguments(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const bool checksPassed =
+        checkNormalizeVectors() &&
+        checkTriangulateFaces() &&
+        checkFindInstanceMasters();
+
+    if (!checksPassed)
+        return EXIT_FAILURE;
+
+    std::vector<Result> results;
+    runBenchmarks(options, results);
+    printResults(results);
+
+    if (!options.m_saveFilename.empty() && !saveResults(options.m_saveFilename, results))
+        return EXIT_FAILURE;
+
+    if (!options.m_compareFilename.empty() &&
+        !compareResults(options.m_compareFilename, options.m_tolerance, results))
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
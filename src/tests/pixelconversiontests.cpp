@@ -0,0 +1,137 @@
+
+//
+// This source file is part of appleseed.
+// Visit https://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed-maya headers.
+#include "appleseedmaya/pixelconversion.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+//
+// Pixel conversion tests.
+//
+//  Check the pixel conversion kernels against their scalar references.
+//
+
+namespace
+{
+
+std::vector<float> randomFloats(
+    const size_t    count,
+    const float     minValue,
+    const float     maxValue,
+    const unsigned  seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(minValue, maxValue);
+
+    std::vector<float> values(count);
+    for (size_t i = 0; i < count; ++i)
+        values[i] = dist(rng);
+
+    return values;
+}
+
+bool checkSRGBConversion()
+{
+    // An odd pixel count, to exercise the tail of the SSE loop.
+    const size_t count = 64 * 64 + 3;
+    std::vector<float> src = randomFloats(count * 4, -0.5f, 1.5f, 1);
+
+    // Values outside the [0, 1] range and around the linear segment of the curve.
+    const float specialValues[] = {0.0f, 1.0f, -1.0f, 2.0f, 0.0031308f, 0.001f, 0.5f, 1.0e-6f};
+    for (size_t i = 0, e = sizeof(specialValues) / sizeof(specialValues[0]); i < e; ++i)
+        src[i] = specialValues[i];
+
+    std::vector<std::uint8_t> fast(count * 4);
+    std::vector<std::uint8_t> reference(count * 4);
+    convertLinearRGBAToSRGB8BGRA(src.data(), count, fast.data());
+    convertLinearRGBAToSRGB8BGRAScalar(src.data(), count, reference.data());
+
+    for (size_t i = 0, e = fast.size(); i < e; ++i)
+    {
+        if (std::abs(static_cast<int>(fast[i]) - static_cast<int>(reference[i])) > 1)
+        {
+            std::fprintf(stderr, "convertLinearRGBAToSRGB8BGRA: mismatch at pixel %zu\n", i / 4);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (fast[i * 4 + 3] != 255)
+        {
+            std::fprintf(stderr, "convertLinearRGBAToSRGB8BGRA: alpha is not opaque at pixel %zu\n", i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool checkCopyFloatRGBAFlipped()
+{
+    // A block inside a wider tile, as for render view tiles clipped to the data window.
+    const size_t srcRowStride = 37;
+    const size_t width = 29;
+    const size_t height = 23;
+    const std::vector<float> src = randomFloats(srcRowStride * height * 4, -1.0f, 2.0f, 2);
+
+    std::vector<float> dst(width * height * 4);
+    copyFloatRGBAFlipped(src.data(), srcRowStride, width, height, dst.data());
+
+    for (size_t y = 0; y < height; ++y)
+    {
+        for (size_t x = 0; x < width * 4; ++x)
+        {
+            if (dst[y * width * 4 + x] != src[(height - 1 - y) * srcRowStride * 4 + x])
+            {
+                std::fprintf(stderr, "copyFloatRGBAFlipped: mismatch at pixel (%zu, %zu)\n", x / 4, y);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+}
+
+int main()
+{
+    const bool checksPassed =
+        checkSRGBConversion() &&
+        checkCopyFloatRGBAFlipped();
+
+    return checksPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -32,13 +32,19 @@
 // appleseed.renderer headers.
 #include "renderer/api/camera.h"
 #include "renderer/api/frame.h"
+#include "renderer/api/object.h"
 #include "renderer/api/project.h"
 #include "renderer/api/scene.h"
 
 // appleseed.foundation headers.
 #include "foundation/containers/dictionary.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
 #include "foundation/math/matrix.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
 #include "foundation/string/string.h"
+#include "foundation/utility/job/iabortswitch.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 
 // appleseed.main headers.
@@ -49,9 +55,20 @@
 #include <XGen/XgRenderAPIUtils.h>
 
 // Standard headers.
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
+#include <functional>
 #include <memory>
+#include <random>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace asf = foundation;
 namespace asr = renderer;
@@ -62,18 +79,503 @@ namespace
 {
     const char* Model = "xgen_patch_assembly";
 
+    // Tessellation of XGen sphere primitives.
+    const size_t SphereResolutionU = 8;
+    const size_t SphereResolutionV = 6;
+
+    asr::GVector3 to_vector(const vec3& v)
+    {
+        return asr::GVector3(v.x, v.y, v.z);
+    }
+
+    //
+    // Primitive cache access.
+    //
+    //  XGen stores the data of primitive batch i and motion sample m
+    //  at index i * sample_count + m.
+    //
+
+    asf::auto_release_ptr<asr::ObjectInstance> create_object_instance(
+        const std::string&      object_name,
+        const asr::ParamArray&  params)
+    {
+        asf::StringDictionary materials;
+        if (params.strings().exist("material"))
+            materials.insert("default", params.get("material"));
+
+        return
+            asr::ObjectInstanceFactory::create(
+                (object_name + "_inst").c_str(),
+                asr::ParamArray(),
+                object_name.c_str(),
+                asf::Transformd::make_identity(),
+                materials,
+                materials);
+    }
+
+    // 64 bit FNV-1a hash, stable across runs and platforms.
+    std::uint64_t hash_string(const std::string& str)
+    {
+        std::uint64_t h = 14695981039346656037ull;
+        for (const char c : str)
+            h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        return h;
+    }
+
+    //
+    // Expansion cache.
+    //
+    //  Stores the objects generated for an assembly in a flat binary file:
+    //
+    //    char[8]   magic
+    //    uint64    object count
+    //    objects:
+    //      uint32  type (0: curves, 1: mesh)
+    //      uint32  name length, followed by the name
+    //      curves: uint64 vertex count, uint64 curve count,
+    //              float3 vertices, float widths, uint32 curve vertex counts
+    //      mesh:   uint64 vertex count, uint64 triangle count, uint64 motion segment count,
+    //              float3 vertices and float3 normals for each motion sample,
+    //              uint32 triangle vertex indices
+    //
+    //  Arrays are stored in native layout and read with one block read each.
+    //
+
+    const char* CacheFileMagic = "ASXGC001";
+    const size_t CacheFileMagicSize = 8;
+
+    enum CachedObjectType : std::uint32_t
+    {
+        CachedCurves = 0,
+        CachedMesh = 1
+    };
+
+    template <typename T>
+    void write_value(std::ofstream& file, const T& value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void write_array(std::ofstream& file, const std::vector<T>& values)
+    {
+        file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    template <typename T>
+    bool read_value(std::ifstream& file, T& value)
+    {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    // Return the number of bytes left to read in a file of a given size.
+    std::uint64_t remaining_size(std::ifstream& file, const std::uint64_t file_size)
+    {
+        const std::streamoff position = file.tellg();
+        return position < 0 || static_cast<std::uint64_t>(position) > file_size
+            ? 0
+            : file_size - static_cast<std::uint64_t>(position);
+    }
+
+    // The count is checked against the size of the file before allocating,
+    // so that a truncated or corrupted file cannot trigger a huge allocation.
+    template <typename T>
+    bool read_array(std::ifstream& file, const std::uint64_t file_size, const std::uint64_t count, std::vector<T>& values)
+    {
+        if (count > remaining_size(file, file_size) / sizeof(T))
+            return false;
+
+        values.resize(count);
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(values.data()), count * sizeof(T)));
+    }
+
+    void write_curves(std::ofstream& file, const asr::CurveObject& curves)
+    {
+        const size_t vertex_count = curves.get_vertex_count();
+        const size_t curve_count = curves.get_curve_count();
+
+        std::vector<asr::GVector3> vertices(vertex_count);
+        std::vector<asr::GScalar> widths(vertex_count);
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            vertices[i] = curves.get_vertex(i);
+            widths[i] = curves.get_vertex_width(i);
+        }
+
+        std::vector<std::uint32_t> vertex_counts(curve_count);
+        for (size_t i = 0; i < curve_count; ++i)
+            vertex_counts[i] = curves.get_curve_vertex_count(i);
+
+        write_value<std::uint64_t>(file, vertex_count);
+        write_value<std::uint64_t>(file, curve_count);
+        write_array(file, vertices);
+        write_array(file, widths);
+        write_array(file, vertex_counts);
+    }
+
+    void write_mesh(std::ofstream& file, const asr::MeshObject& mesh)
+    {
+        const size_t vertex_count = mesh.get_vertex_count();
+        const size_t triangle_count = mesh.get_triangle_count();
+        const size_t segment_count = mesh.get_motion_segment_count();
+
+        std::vector<asr::GVector3> vertices;
+        std::vector<asr::GVector3> normals;
+        vertices.reserve(vertex_count * (segment_count + 1));
+        normals.reserve(vertex_count * (segment_count + 1));
+
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            vertices.push_back(mesh.get_vertex(i));
+            normals.push_back(mesh.get_vertex_normal(i));
+        }
+
+        for (size_t m = 0; m < segment_count; ++m)
+        {
+            for (size_t i = 0; i < vertex_count; ++i)
+            {
+                vertices.push_back(mesh.get_vertex_pose(i, m));
+                normals.push_back(mesh.get_vertex_normal_pose(i, m));
+            }
+        }
+
+        std::vector<std::uint32_t> triangles;
+        triangles.reserve(triangle_count * 3);
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            const asr::Triangle& triangle = mesh.get_triangle(i);
+            triangles.push_back(triangle.m_v0);
+            triangles.push_back(triangle.m_v1);
+            triangles.push_back(triangle.m_v2);
+        }
+
+        write_value<std::uint64_t>(file, vertex_count);
+        write_value<std::uint64_t>(file, triangle_count);
+        write_value<std::uint64_t>(file, segment_count);
+        write_array(file, vertices);
+        write_array(file, normals);
+        write_array(file, triangles);
+    }
+
+    asf::auto_release_ptr<asr::Object> read_curves(
+        std::ifstream&          file,
+        const std::uint64_t     file_size,
+        const std::string&      name)
+    {
+        std::uint64_t vertex_count, curve_count;
+        std::vector<asr::GVector3> vertices;
+        std::vector<asr::GScalar> widths;
+        std::vector<std::uint32_t> vertex_counts;
+
+        if (!read_value(file, vertex_count) ||
+            !read_value(file, curve_count) ||
+            !read_array(file, file_size, vertex_count, vertices) ||
+            !read_array(file, file_size, vertex_count, widths) ||
+            !read_array(file, file_size, curve_count, vertex_counts))
+            return asf::auto_release_ptr<asr::Object>();
+
+        asf::auto_release_ptr<asr::CurveObject> curves(
+            asr::CurveObjectFactory::create(
+                name.c_str(),
+                asr::ParamArray().insert("basis", "bspline")));
+
+        curves->reserve_vertices(vertex_count);
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            curves->push_vertex(vertices[i]);
+            curves->push_vertex_width(widths[i]);
+        }
+
+        curves->reserve_curves(curve_count);
+        for (size_t i = 0; i < curve_count; ++i)
+            curves->push_curve_vertex_count(vertex_counts[i]);
+
+        return asf::auto_release_ptr<asr::Object>(curves.release());
+    }
+
+    asf::auto_release_ptr<asr::Object> read_mesh(
+        std::ifstream&          file,
+        const std::uint64_t     file_size,
+        const std::string&      name)
+    {
+        std::uint64_t vertex_count, triangle_count, segment_count;
+        std::vector<asr::GVector3> vertices;
+        std::vector<asr::GVector3> normals;
+        std::vector<std::uint32_t> triangles;
+
+        if (!read_value(file, vertex_count) ||
+            !read_value(file, triangle_count) ||
+            !read_value(file, segment_count) ||
+            segment_count >= file_size ||
+            vertex_count > file_size / (segment_count + 1) ||
+            triangle_count > file_size / 3 ||
+            !read_array(file, file_size, vertex_count * (segment_count + 1), vertices) ||
+            !read_array(file, file_size, vertex_count * (segment_count + 1), normals) ||
+            !read_array(file, file_size, triangle_count * 3, triangles))
+            return asf::auto_release_ptr<asr::Object>();
+
+        asf::auto_release_ptr<asr::MeshObject> mesh(
+            asr::MeshObjectFactory().create(name.c_str(), asr::ParamArray()));
+
+        mesh->reserve_vertices(vertex_count);
+        mesh->reserve_vertex_normals(vertex_count);
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            mesh->push_vertex(vertices[i]);
+            mesh->push_vertex_normal(normals[i]);
+        }
+
+        if (segment_count > 0)
+        {
+            mesh->set_motion_segment_count(segment_count);
+
+            for (size_t m = 0; m < segment_count; ++m)
+            {
+                const size_t offset = (m + 1) * vertex_count;
+                for (size_t i = 0; i < vertex_count; ++i)
+                {
+                    mesh->set_vertex_pose(i, m, vertices[offset + i]);
+                    mesh->set_vertex_normal_pose(i, m, normals[offset + i]);
+                }
+            }
+        }
+
+        mesh->reserve_triangles(triangle_count);
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            asr::Triangle triangle(triangles[3 * i], triangles[3 * i + 1], triangles[3 * i + 2], 0);
+            triangle.m_n0 = triangle.m_v0;
+            triangle.m_n1 = triangle.m_v1;
+            triangle.m_n2 = triangle.m_v2;
+            mesh->push_triangle(triangle);
+        }
+
+        mesh->push_material_slot("default");
+        return asf::auto_release_ptr<asr::Object>(mesh.release());
+    }
+
+    // Write the objects of an assembly to a cache file.
+    bool save_cache_file(const std::string& path, const asr::Assembly& assembly)
+    {
+        // Write to a temporary file first, so that readers never see partial files.
+        // The name is unique so that concurrent renders do not write to the same file.
+        std::random_device random;
+        const std::string tmp_path =
+            asf::format(
+                "{0}.{1}{2}.tmp",
+                path,
+                std::hash<std::thread::id>()(std::this_thread::get_id()),
+                random());
+
+        {
+            std::ofstream file(tmp_path.c_str(), std::ios::out | std::ios::binary);
+            if (!file)
+                return false;
+
+            file.write(CacheFileMagic, CacheFileMagicSize);
+            write_value<std::uint64_t>(file, assembly.objects().size());
+
+            for (const asr::Object& object : assembly.objects())
+            {
+                const std::string name = object.get_name();
+                const bool is_curves = strcmp(object.get_model(), asr::CurveObjectFactory::get_model()) == 0;
+
+                write_value<std::uint32_t>(file, is_curves ? CachedCurves : CachedMesh);
+                write_value<std::uint32_t>(file, static_cast<std::uint32_t>(name.size()));
+                file.write(name.data(), name.size());
+
+                if (is_curves)
+                    write_curves(file, static_cast<const asr::CurveObject&>(object));
+                else
+                    write_mesh(file, static_cast<const asr::MeshObject&>(object));
+            }
+
+            if (!file)
+            {
+                file.close();
+                std::remove(tmp_path.c_str());
+                return false;
+            }
+        }
+
+        // Renaming fails on some platforms if another render already wrote
+        // the cache file. Its content is the same, so keep it.
+        if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+        {
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    // Load the objects of a cache file into an assembly, and instance them.
+    bool load_cache_file(const std::string& path, asr::Assembly& assembly)
+    {
+        std::ifstream file(path.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+
+        const std::streamoff end = file.tellg();
+        if (end < 0 || !file.seekg(0))
+            return false;
+
+        const std::uint64_t file_size = static_cast<std::uint64_t>(end);
+
+        char magic[CacheFileMagicSize];
+        std::uint64_t object_count;
+        if (!file.read(magic, CacheFileMagicSize) ||
+            memcmp(magic, CacheFileMagic, CacheFileMagicSize) != 0 ||
+            !read_value(file, object_count))
+            return false;
+
+        std::vector<asf::auto_release_ptr<asr::Object>> objects;
+        for (std::uint64_t i = 0; i < object_count; ++i)
+        {
+            std::uint32_t type, name_length;
+            if (!read_value(file, type) ||
+                !read_value(file, name_length) ||
+                name_length > remaining_size(file, file_size))
+                return false;
+
+            std::string name(name_length, '\0');
+            if (!file.read(&name[0], name_length))
+                return false;
+
+            asf::auto_release_ptr<asr::Object> object =
+                type == CachedCurves
+                    ? read_curves(file, file_size, name)
+                    : read_mesh(file, file_size, name);
+
+            if (object.get() == nullptr)
+                return false;
+
+            objects.push_back(object);
+        }
+
+        for (asf::auto_release_ptr<asr::Object>& object : objects)
+        {
+            assembly.object_instances().insert(
+                create_object_instance(object->get_name(), assembly.get_parameters()));
+            assembly.objects().insert(object);
+        }
+
+        return true;
+    }
+
+    struct PrimitiveBatch
+    {
+        PrimitiveBatch(PrimitiveCache* cache, const unsigned int batch, const unsigned int sample_count)
+          : m_cache(cache)
+          , m_index(batch * sample_count)
+        {
+        }
+
+        unsigned int primitive_count() const
+        {
+            return m_cache->getSize2(PrimitiveCache::NumVertices, m_index);
+        }
+
+        const int* vertex_counts() const
+        {
+            return m_cache->get(PrimitiveCache::NumVertices, m_index);
+        }
+
+        unsigned int point_count() const
+        {
+            return m_cache->getSize2(PrimitiveCache::Points, m_index);
+        }
+
+        const vec3* points(const unsigned int sample) const
+        {
+            return m_cache->get(PrimitiveCache::Points, m_index + sample);
+        }
+
+        // Per point widths, or nullptr if the primitives have a constant width.
+        const float* widths() const
+        {
+            return m_cache->getSize2(PrimitiveCache::Widths, m_index) >= point_count()
+                ? m_cache->get(PrimitiveCache::Widths, m_index)
+                : nullptr;
+        }
+
+        // Per primitive normals, or nullptr if there are none.
+        const vec3* normals() const
+        {
+            return m_cache->getSize2(PrimitiveCache::Norms, m_index) >= primitive_count()
+                ? m_cache->get(PrimitiveCache::Norms, m_index)
+                : nullptr;
+        }
+
+        PrimitiveCache*     m_cache;
+        const unsigned int  m_index;
+    };
+
     class XGenCallbacks
       : public ProceduralCallbacks
     {
       public:
         XGenCallbacks(
             const asr::Project& project,
-            asr::Assembly&      assembly)
+            asr::Assembly&      assembly,
+            const size_t        worker_index = 0)
           : m_assembly(assembly)
           , m_params(assembly.get_parameters())
+          , m_worker_index(worker_index)
+          , m_object_index(0)
+          , m_warned_archives(false)
+          , m_mesh_vertex_base(0)
+          , m_camera_is_persp(false)
+          , m_density_falloff_enabled(false)
         {
             add_xgen_params(project);
             compute_transform_sequence(assembly);
+            init_lod_params();
+        }
+
+        ~XGenCallbacks()
+        {
+            for (asr::Object* object : m_objects)
+                object->release();
+
+            for (asr::ObjectInstance* object_instance : m_object_instances)
+                object_instance->release();
+        }
+
+        // Parameters that change the generated primitives, in addition to the XGen arguments.
+        // XGen culls and orients primitives using the render camera, so it is always included.
+        std::string get_cache_variant() const
+        {
+            const std::string camera =
+                asf::format(
+                    "{0};{1};{2};{3}",
+                    get_string("irRenderCam"),
+                    get_string("irRenderCamFOV"),
+                    get_string("irRenderCamRatio"),
+                    get_string("irRenderCamXform"));
+
+            if (!m_density_falloff_enabled)
+                return asf::format("{0};{1}", get_string("shutter"), camera);
+
+            return asf::format(
+                "{0};{1};{2};{3}",
+                get_string("shutter"),
+                camera,
+                get_string("density_falloff"),
+                get_string("width_compensation", "true"));
+        }
+
+        // Move the entities created by the flush callbacks to the assembly.
+        void move_entities_to(asr::Assembly& assembly)
+        {
+            for (asr::Object* object : m_objects)
+                assembly.objects().insert(asf::auto_release_ptr<asr::Object>(object));
+
+            for (asr::ObjectInstance* object_instance : m_object_instances)
+                assembly.object_instances().insert(asf::auto_release_ptr<asr::ObjectInstance>(object_instance));
+
+            m_objects.clear();
+            m_object_instances.clear();
         }
 
         void flush(const char* in_geom, PrimitiveCache* in_cache) override
@@ -100,24 +602,428 @@ namespace
             }
         }
 
+        // Each flush creates a single object holding all the primitives of the
+        // cache, sized upfront from the cache contents. Scratch buffers are
+        // members, reused across flushes.
+
         void flush_splines(const char* in_geom, PrimitiveCache* in_cache)
         {
-            RENDERER_LOG_DEBUG("XGenCallbacks: flush_splines called");
+            const unsigned int batch_count = in_cache->get(PrimitiveCache::CacheCount);
+            const unsigned int sample_count = get_sample_count(in_cache);
+            const float constant_width = in_cache->get(PrimitiveCache::ConstantWidth);
+
+            // appleseed curves do not support deformation motion blur,
+            // motion blurred splines are converted to ribbons.
+            if (sample_count > 1)
+            {
+                flush_spline_ribbons(in_geom, in_cache);
+                return;
+            }
+
+            // Select the strands to keep, and their width scale.
+            m_strand_scales.clear();
+
+            size_t curve_count = 0;
+            size_t vertex_count = 0;
+            for (unsigned int i = 0; i < batch_count; ++i)
+            {
+                const PrimitiveBatch batch(in_cache, i, sample_count);
+                const vec3* points = batch.points(0);
+                const int* vertex_counts = batch.vertex_counts();
+                size_t first_point = 0;
+
+                for (unsigned int j = 0, je = batch.primitive_count(); j < je; ++j)
+                {
+                    const float scale = strand_width_scale(points[first_point]);
+                    m_strand_scales.push_back(scale);
+
+                    if (scale > 0.0f)
+                    {
+                        ++curve_count;
+                        vertex_count += vertex_counts[j];
+                    }
+
+                    first_point += vertex_counts[j];
+                }
+            }
+
+            if (curve_count == 0)
+                return;
+
+            asf::auto_release_ptr<asr::CurveObject> curves(
+                asr::CurveObjectFactory::create(
+                    make_object_name("curves").c_str(),
+                    asr::ParamArray().insert("basis", "bspline")));
+
+            curves->reserve_curves(curve_count);
+            curves->reserve_vertices(vertex_count);
+
+            size_t strand_index = 0;
+            for (unsigned int i = 0; i < batch_count; ++i)
+            {
+                const PrimitiveBatch batch(in_cache, i, sample_count);
+                const vec3* points = batch.points(0);
+                const float* widths = batch.widths();
+                const int* vertex_counts = batch.vertex_counts();
+                size_t first_point = 0;
+
+                for (unsigned int j = 0, je = batch.primitive_count(); j < je; ++j)
+                {
+                    const float scale = m_strand_scales[strand_index++];
+                    const size_t end_point = first_point + vertex_counts[j];
+
+                    if (scale > 0.0f)
+                    {
+                        for (size_t k = first_point; k < end_point; ++k)
+                        {
+                            curves->push_vertex(to_vector(points[k]));
+                            curves->push_vertex_width(scale * (widths ? widths[k] : constant_width));
+                        }
+
+                        curves->push_curve_vertex_count(static_cast<std::uint32_t>(vertex_counts[j]));
+                    }
+
+                    first_point = end_point;
+                }
+            }
+
+            insert_object(asf::auto_release_ptr<asr::Object>(curves.release()));
+        }
+
+        // Motion blurred splines become ribbons facing the camera at shutter open,
+        // with one vertex pose per motion sample.
+        void flush_spline_ribbons(const char* in_geom, PrimitiveCache* in_cache)
+        {
+            const unsigned int batch_count = in_cache->get(PrimitiveCache::CacheCount);
+            const unsigned int sample_count = get_sample_count(in_cache);
+            const float constant_width = in_cache->get(PrimitiveCache::ConstantWidth);
+
+            // Select the strands to keep, their width scale and orientation.
+            m_strand_scales.clear();
+            m_strand_normals.clear();
+
+            size_t vertex_count = 0;
+            size_t triangle_count = 0;
+            for (unsigned int i = 0; i < batch_count; ++i)
+            {
+                const PrimitiveBatch batch(in_cache, i, sample_count);
+                const vec3* points = batch.points(0);
+                const int* vertex_counts = batch.vertex_counts();
+                size_t first_point = 0;
+
+                for (unsigned int j = 0, je = batch.primitive_count(); j < je; ++j)
+                {
+                    const float scale = strand_width_scale(points[first_point]);
+                    m_strand_scales.push_back(scale);
+
+                    const asr::GVector3 root = to_vector(points[first_point]);
+                    m_strand_normals.push_back(
+                        m_camera_is_persp
+                            ? asf::safe_normalize(
+                                  asr::GVector3(m_camera_position) - root,
+                                  asr::GVector3(0.0f, 0.0f, 1.0f))
+                            : asr::GVector3(0.0f, 0.0f, 1.0f));
+
+                    if (scale > 0.0f)
+                    {
+                        vertex_count += 2 * vertex_counts[j];
+                        triangle_count += 2 * std::max(vertex_counts[j] - 1, 0);
+                    }
+
+                    first_point += vertex_counts[j];
+                }
+            }
+
+            if (triangle_count == 0)
+                return;
+
+            asf::auto_release_ptr<asr::MeshObject> mesh(
+                asr::MeshObjectFactory().create(make_object_name("strands").c_str(), asr::ParamArray()));
+            begin_mesh(*mesh, vertex_count, triangle_count, sample_count);
+
+            size_t first_strand = 0;
+            for (unsigned int i = 0; i < batch_count; ++i)
+            {
+                const PrimitiveBatch batch(in_cache, i, sample_count);
+                const int* vertex_counts = batch.vertex_counts();
+                const float* widths = batch.widths();
+
+                for (unsigned int m = 0; m < sample_count; ++m)
+                {
+                    m_vertices.clear();
+                    m_normals.clear();
+
+                    const vec3* points = batch.points(m);
+                    size_t first_point = 0;
+
+                    for (unsigned int j = 0, je = batch.primitive_count(); j < je; ++j)
+                    {
+                        const float scale = m_strand_scales[first_strand + j];
+
+                        if (scale > 0.0f)
+                        {
+                            append_ribbon(
+                                points + first_point,
+                                widths ? widths + first_point : nullptr,
+                                constant_width,
+                                static_cast<size_t>(vertex_counts[j]),
+                                m_strand_normals[first_strand + j],
+                                scale);
+                        }
+
+                        first_point += vertex_counts[j];
+                    }
+
+                    push_mesh_sample(*mesh, m);
+                }
+
+                size_t base = m_mesh_vertex_base;
+                for (unsigned int j = 0, je = batch.primitive_count(); j < je; ++j)
+                {
+                    if (m_strand_scales[first_strand + j] == 0.0f)
+                        continue;
+
+                    for (int k = 0; k + 1 < vertex_counts[j]; ++k)
+                    {
+                        const size_t v = base + 2 * k;
+                        push_triangle(*mesh, v, v + 1, v + 2);
+                        push_triangle(*mesh, v + 1, v + 3, v + 2);
+                    }
+
+                    base += 2 * vertex_counts[j];
+                }
+
+                m_mesh_vertex_base = base;
+                first_strand += batch.primitive_count();
+            }
+
+            insert_object(asf::auto_release_ptr<asr::Object>(mesh.release()));
         }
 
         void flush_cards(const char* in_geom, PrimitiveCache* in_cache)
         {
-            RENDERER_LOG_DEBUG("XGenCallbacks: flush_cards called");
+            const unsigned int batch_count = in_cache->get(PrimitiveCache::CacheCount);
+            const unsigned int sample_count = get_sample_count(in_cache);
+            const float constant_width = in_cache->get(PrimitiveCache::ConstantWidth);
+
+            // Cards are ribbons along their spine: two vertices per spine point
+            // and two triangles per spine segment. Select the cards to keep,
+            // and their width scale.
+            m_strand_scales.clear();
+
+            size_t vertex_count = 0;
+            size_t triangle_count = 0;
+            for (unsigned int i = 0; i < batch_count; ++i)
+            {
+                const PrimitiveBatch batch(in_cache, i, sample_count);
+                const vec3* points = batch.points(0);
+                const int* vertex_counts = batch.vertex_counts();
+                size_t first_point = 0;
+
+                for (unsigned int j = 0, je = batch.primitive_count(); j < je; ++j)
+                {
+                    const float scale = strand_width_scale(points[first_point]);
+                    m_strand_scales.push_back(scale);
+
+                    if (scale > 0.0f)
+                    {
+                        vertex_count += 2 * vertex_counts[j];
+                        triangle_count += 2 * std::max(vertex_counts[j] - 1, 0);
+                    }
+
+                    first_point += vertex_counts[j];
+                }
+            }
+
+            if (triangle_count == 0)
+                return;
+
+            asf::auto_release_ptr<asr::MeshObject> mesh(
+                asr::MeshObjectFactory().create(make_object_name("cards").c_str(), asr::ParamArray()));
+            begin_mesh(*mesh, vertex_count, triangle_count, sample_count);
+
+            size_t first_card = 0;
+            for (unsigned int i = 0; i < batch_count; ++i)
+            {
+                const PrimitiveBatch batch(in_cache, i, sample_count);
+                const int* vertex_counts = batch.vertex_counts();
+                const float* widths = batch.widths();
+                const vec3* normals = batch.normals();
+
+                for (unsigned int m = 0; m < sample_count; ++m)
+                {
+                    m_vertices.clear();
+                    m_normals.clear();
+
+                    const vec3* points = batch.points(m);
+                    size_t first_point = 0;
+
+                    for (unsigned int j = 0, je = batch.primitive_count(); j < je; ++j)
+                    {
+                        const float scale = m_strand_scales[first_card + j];
+
+                        if (scale > 0.0f)
+                        {
+                            const asr::GVector3 N = normals
+                                ? asf::safe_normalize(to_vector(normals[j]), asr::GVector3(0.0f, 0.0f, 1.0f))
+                                : asr::GVector3(0.0f, 0.0f, 1.0f);
+
+                            append_ribbon(
+                                points + first_point,
+                                widths ? widths + first_point : nullptr,
+                                constant_width,
+                                static_cast<size_t>(vertex_counts[j]),
+                                N,
+                                scale);
+                        }
+
+                        first_point += vertex_counts[j];
+                    }
+
+                    push_mesh_sample(*mesh, m);
+                }
+
+                // Topology only depends on the point counts.
+                size_t base = m_mesh_vertex_base;
+                for (unsigned int j = 0, je = batch.primitive_count(); j < je; ++j)
+                {
+                    if (m_strand_scales[first_card + j] == 0.0f)
+                        continue;
+
+                    for (int k = 0; k + 1 < vertex_counts[j]; ++k)
+                    {
+                        const size_t v = base + 2 * k;
+                        push_triangle(*mesh, v, v + 1, v + 2);
+                        push_triangle(*mesh, v + 1, v + 3, v + 2);
+                    }
+
+                    base += 2 * vertex_counts[j];
+                }
+
+                m_mesh_vertex_base = base;
+                first_card += batch.primitive_count();
+            }
+
+            insert_object(asf::auto_release_ptr<asr::Object>(mesh.release()));
         }
 
         void flush_spheres(const char* in_geom, PrimitiveCache* in_cache)
         {
-            RENDERER_LOG_DEBUG("XGenCallbacks: flush_spheres called");
+            const unsigned int batch_count = in_cache->get(PrimitiveCache::CacheCount);
+            const unsigned int sample_count = get_sample_count(in_cache);
+            const float constant_width = in_cache->get(PrimitiveCache::ConstantWidth);
+
+            init_sphere_template();
+
+            // Select the spheres to keep, and their radius scale. The projected
+            // area of a sphere grows with the square of its radius.
+            m_strand_scales.clear();
+
+            size_t sphere_count = 0;
+            for (unsigned int i = 0; i < batch_count; ++i)
+            {
+                const PrimitiveBatch batch(in_cache, i, sample_count);
+                const vec3* points = batch.points(0);
+                const int* vertex_counts = batch.vertex_counts();
+                size_t first_point = 0;
+
+                for (unsigned int j = 0, je = batch.primitive_count(); j < je; ++j)
+                {
+                    const float scale = std::sqrt(strand_width_scale(points[first_point]));
+                    m_strand_scales.push_back(scale);
+
+                    if (scale > 0.0f)
+                        ++sphere_count;
+
+                    first_point += vertex_counts[j];
+                }
+            }
+
+            if (sphere_count == 0)
+                return;
+
+            asf::auto_release_ptr<asr::MeshObject> mesh(
+                asr::MeshObjectFactory().create(make_object_name("spheres").c_str(), asr::ParamArray()));
+            begin_mesh(
+                *mesh,
+                sphere_count * m_sphere_vertices.size(),
+                sphere_count * m_sphere_triangles.size() / 3,
+                sample_count);
+
+            size_t first_sphere = 0;
+            for (unsigned int i = 0; i < batch_count; ++i)
+            {
+                const PrimitiveBatch batch(in_cache, i, sample_count);
+                const int* vertex_counts = batch.vertex_counts();
+                const float* widths = batch.widths();
+
+                for (unsigned int m = 0; m < sample_count; ++m)
+                {
+                    m_vertices.clear();
+                    m_normals.clear();
+
+                    const vec3* points = batch.points(m);
+                    size_t first_point = 0;
+
+                    // Spheres are centered on the first point of the primitive.
+                    for (unsigned int j = 0, je = batch.primitive_count(); j < je; ++j)
+                    {
+                        const float scale = m_strand_scales[first_sphere + j];
+
+                        if (scale > 0.0f)
+                        {
+                            const asr::GVector3 center = to_vector(points[first_point]);
+                            const float radius =
+                                0.5f * scale * (widths ? widths[first_point] : constant_width);
+
+                            for (size_t k = 0, ke = m_sphere_vertices.size(); k < ke; ++k)
+                            {
+                                m_vertices.push_back(center + radius * m_sphere_vertices[k]);
+                                m_normals.push_back(m_sphere_vertices[k]);
+                            }
+                        }
+
+                        first_point += vertex_counts[j];
+                    }
+
+                    push_mesh_sample(*mesh, m);
+                }
+
+                size_t base = m_mesh_vertex_base;
+                for (unsigned int j = 0, je = batch.primitive_count(); j < je; ++j)
+                {
+                    if (m_strand_scales[first_sphere + j] == 0.0f)
+                        continue;
+
+                    for (size_t k = 0, ke = m_sphere_triangles.size(); k < ke; k += 3)
+                    {
+                        push_triangle(
+                            *mesh,
+                            base + m_sphere_triangles[k],
+                            base + m_sphere_triangles[k + 1],
+                            base + m_sphere_triangles[k + 2]);
+                    }
+
+                    base += m_sphere_vertices.size();
+                }
+
+                m_mesh_vertex_base = base;
+                first_sphere += batch.primitive_count();
+            }
+
+            insert_object(asf::auto_release_ptr<asr::Object>(mesh.release()));
         }
 
         void flush_archives(const char* in_geom, PrimitiveCache* in_cache)
         {
-            RENDERER_LOG_DEBUG("XGenCallbacks: flush_archives called");
+            // Archives reference external geometry files (Alembic, ASS, RIB...)
+            // that appleseed can't load from a procedural assembly.
+            if (!m_warned_archives)
+            {
+                RENDERER_LOG_WARNING(
+                    "XGen procedural assembly: archive primitives are not supported, skipping them");
+                m_warned_archives = true;
+            }
         }
 
         void log(const char* in_str)  override
@@ -202,32 +1108,14 @@ namespace
 
         const float* get(EFloatArrayAttribute attr) const override
         {
-            switch (attr)
-            {
-                case DensityFalloff:
-                case LodHi:
-                case LodLow:
-                case LodMed:
-                case Shutter:
-                    return nullptr;
-            }
-
-            return nullptr;
+            const std::vector<float>* values = get_float_array(attr);
+            return values && !values->empty() ? values->data() : nullptr;
         }
 
         unsigned int getSize(EFloatArrayAttribute attr) const override
         {
-            switch (attr)
-            {
-                case DensityFalloff:
-                case LodHi:
-                case LodLow:
-                case LodMed:
-                case Shutter:
-                    return 0;
-            }
-
-            return 0;
+            const std::vector<float>* values = get_float_array(attr);
+            return values ? static_cast<unsigned int>(values->size()) : 0;
         }
 
         const char* getOverride(const char* name) const override
@@ -256,9 +1144,277 @@ namespace
         }
 
       private:
-        asr::Assembly&          m_assembly;
-        asr::ParamArray         m_params;
-        asr::TransformSequence  m_transform_sequence;
+        asr::Assembly&              m_assembly;
+        asr::ParamArray             m_params;
+        asr::TransformSequence      m_transform_sequence;
+        const size_t                m_worker_index;
+        size_t                      m_object_index;
+        bool                        m_warned_archives;
+
+        // Entities created by the flush callbacks, owned until moved to the assembly.
+        std::vector<asr::Object*>           m_objects;
+        std::vector<asr::ObjectInstance*>   m_object_instances;
+
+        // Scratch buffers, reused across flushes.
+        std::vector<asr::GVector3>  m_vertices;
+        std::vector<asr::GVector3>  m_normals;
+        size_t                      m_mesh_vertex_base;
+
+        // Unit sphere, instanced for sphere primitives.
+        std::vector<asr::GVector3>  m_sphere_vertices;
+        std::vector<size_t>         m_sphere_triangles;
+
+        // Camera, in the space of the primitives.
+        bool                        m_camera_is_persp;
+        asf::Vector3f               m_camera_position;
+
+        // Level of detail.
+        std::vector<float>          m_shutter;
+        bool                        m_density_falloff_enabled;
+        float                       m_density_falloff_start;
+        float                       m_density_falloff_end;
+        float                       m_min_density;
+        bool                        m_width_compensation;
+        std::vector<float>          m_strand_scales;
+        std::vector<asr::GVector3>  m_strand_normals;
+
+        const std::vector<float>* get_float_array(EFloatArrayAttribute attr) const
+        {
+            switch (attr)
+            {
+                // XGen level of detail is not used. Distance based simplification
+                // is done by the density falloff instead.
+                case LodHi:
+                case LodMed:
+                case LodLow:
+                    return nullptr;
+
+                // XGen generates one motion sample per shutter time,
+                // in a single pass over the patch.
+                case Shutter:
+                    return m_shutter.size() > 1 ? &m_shutter : nullptr;
+
+                // Density falloff is applied by the flush callbacks,
+                // to splines, cards and spheres. Archives are not supported.
+                case DensityFalloff:
+                    return nullptr;
+            }
+
+            return nullptr;
+        }
+
+        static std::vector<float> parse_floats(const char* str)
+        {
+            std::vector<float> values;
+            std::istringstream ss(str);
+
+            float value;
+            while (ss >> value)
+                values.push_back(value);
+
+            return values;
+        }
+
+        void init_lod_params()
+        {
+            // shutter: deformation sample times, in frames relative to the current frame.
+            m_shutter = parse_floats(get_string("shutter"));
+
+            // Primitives are created in the space of the patch assembly.
+            asf::Transformd scratch;
+            const asf::Transformd& transform = m_transform_sequence.evaluate(0.0f, scratch);
+            m_camera_position =
+                asf::Vector3f(transform.point_to_local(asf::Vector3d(m_camera_position)));
+
+            // density_falloff: start distance, end distance, minimum density.
+            const std::vector<float> falloff = parse_floats(get_string("density_falloff"));
+            if (falloff.size() == 3 && m_camera_is_persp)
+            {
+                m_density_falloff_enabled = true;
+                m_density_falloff_start = falloff[0];
+                m_density_falloff_end = std::max(falloff[1], falloff[0]);
+                m_min_density = asf::clamp(falloff[2], 0.001f, 1.0f);
+                m_width_compensation = get_param("width_compensation", true);
+            }
+        }
+
+        // Return the width scale of a strand, or 0 if the strand is culled.
+        float strand_width_scale(const vec3& root) const
+        {
+            if (!m_density_falloff_enabled)
+                return 1.0f;
+
+            const asf::Vector3f P(root.x, root.y, root.z);
+            const float distance = asf::norm(P - m_camera_position);
+
+            float density = 1.0f;
+            if (distance >= m_density_falloff_end)
+                density = m_min_density;
+            else if (distance > m_density_falloff_start)
+            {
+                const float t =
+                    (distance - m_density_falloff_start) /
+                    (m_density_falloff_end - m_density_falloff_start);
+                density = asf::lerp(1.0f, m_min_density, t);
+            }
+
+            if (density >= 1.0f)
+                return 1.0f;
+
+            // Keep strands based on a hash of their root position,
+            // so that the selection is stable across frames and workers.
+            std::uint32_t h = 2166136261u;
+            const float coords[3] = { root.x, root.y, root.z };
+            for (const float c : coords)
+            {
+                std::uint32_t bits;
+                std::memcpy(&bits, &c, sizeof(bits));
+                h = (h ^ bits) * 16777619u;
+            }
+            h ^= h >> 15;
+            h *= 0x2c1b3c6du;
+            h ^= h >> 12;
+
+            const float u = static_cast<float>(h >> 8) / static_cast<float>(1u << 24);
+            if (u >= density)
+                return 0.0f;
+
+            // Thicker strands keep the coverage of the groom.
+            return m_width_compensation ? 1.0f / density : 1.0f;
+        }
+
+        static unsigned int get_sample_count(PrimitiveCache* cache)
+        {
+            const int sample_count = cache->get(PrimitiveCache::NumMotionSamples);
+            return static_cast<unsigned int>(std::max(sample_count, 1));
+        }
+
+        std::string make_object_name(const char* prefix)
+        {
+            // Unique across workers.
+            return asf::format("{0}_{1}_{2}", prefix, m_worker_index, m_object_index++);
+        }
+
+        void insert_object(asf::auto_release_ptr<asr::Object> object)
+        {
+            m_object_instances.push_back(
+                create_object_instance(object->get_name(), m_params).release());
+            m_objects.push_back(object.release());
+        }
+
+        void begin_mesh(
+            asr::MeshObject&    mesh,
+            const size_t        vertex_count,
+            const size_t        triangle_count,
+            const unsigned int  sample_count)
+        {
+            mesh.reserve_vertices(vertex_count);
+            mesh.reserve_vertex_normals(vertex_count);
+            mesh.reserve_triangles(triangle_count);
+            mesh.push_material_slot("default");
+
+            if (sample_count > 1)
+                mesh.set_motion_segment_count(sample_count - 1);
+
+            m_mesh_vertex_base = 0;
+        }
+
+        // Append the scratch vertices as a motion sample of the mesh.
+        void push_mesh_sample(asr::MeshObject& mesh, const unsigned int sample) const
+        {
+            if (sample == 0)
+            {
+                for (size_t k = 0, ke = m_vertices.size(); k < ke; ++k)
+                {
+                    mesh.push_vertex(m_vertices[k]);
+                    mesh.push_vertex_normal(m_normals[k]);
+                }
+            }
+            else
+            {
+                for (size_t k = 0, ke = m_vertices.size(); k < ke; ++k)
+                {
+                    mesh.set_vertex_pose(m_mesh_vertex_base + k, sample - 1, m_vertices[k]);
+                    mesh.set_vertex_normal_pose(m_mesh_vertex_base + k, sample - 1, m_normals[k]);
+                }
+            }
+        }
+
+        static void push_triangle(
+            asr::MeshObject&    mesh,
+            const size_t        v0,
+            const size_t        v1,
+            const size_t        v2)
+        {
+            asr::Triangle triangle(
+                static_cast<std::uint32_t>(v0),
+                static_cast<std::uint32_t>(v1),
+                static_cast<std::uint32_t>(v2),
+                0);
+
+            triangle.m_n0 = triangle.m_v0;
+            triangle.m_n1 = triangle.m_v1;
+            triangle.m_n2 = triangle.m_v2;
+            mesh.push_triangle(triangle);
+        }
+
+        // Append the vertices of a ribbon following a card spine.
+        void append_ribbon(
+            const vec3*             points,
+            const float*            widths,
+            const float             constant_width,
+            const size_t            point_count,
+            const asr::GVector3&    N,
+            const float             width_scale = 1.0f)
+        {
+            for (size_t k = 0; k < point_count; ++k)
+            {
+                const asr::GVector3 P = to_vector(points[k]);
+                const asr::GVector3 T = to_vector(points[std::min(k + 1, point_count - 1)]) -
+                                        to_vector(points[k > 0 ? k - 1 : 0]);
+
+                const float half_width = 0.5f * width_scale * (widths ? widths[k] : constant_width);
+                const asr::GVector3 side =
+                    half_width * asf::safe_normalize(asf::cross(T, N), asr::GVector3(1.0f, 0.0f, 0.0f));
+
+                m_vertices.push_back(P - side);
+                m_vertices.push_back(P + side);
+                m_normals.push_back(N);
+                m_normals.push_back(N);
+            }
+        }
+
+        void init_sphere_template()
+        {
+            if (!m_sphere_vertices.empty())
+                return;
+
+            // Poles are duplicated per column, which keeps the indexing simple.
+            for (size_t v = 0; v <= SphereResolutionV; ++v)
+            {
+                const float theta = asf::Pi<float>() * v / SphereResolutionV;
+
+                for (size_t u = 0; u <= SphereResolutionU; ++u)
+                {
+                    const float phi = asf::TwoPi<float>() * u / SphereResolutionU;
+                    m_sphere_vertices.emplace_back(
+                        std::sin(theta) * std::cos(phi),
+                        std::cos(theta),
+                        std::sin(theta) * std::sin(phi));
+                }
+            }
+
+            const size_t row = SphereResolutionU + 1;
+            for (size_t v = 0; v < SphereResolutionV; ++v)
+            {
+                for (size_t u = 0; u < SphereResolutionU; ++u)
+                {
+                    const size_t i = v * row + u;
+                    m_sphere_triangles.insert(m_sphere_triangles.end(), { i, i + row, i + 1 });
+                    m_sphere_triangles.insert(m_sphere_triangles.end(), { i + 1, i + row, i + row + 1 });
+                }
+            }
+        }
 
         const asr::ParamArray& get_parameters() const
         {
@@ -315,19 +1471,22 @@ namespace
                         camera_pos_or_dir.z));
             }
 
+            m_camera_is_persp = camera_is_persp;
+            m_camera_position = asf::Vector3f(transform.get_local_to_parent().extract_translation());
+
             if (!m_params.strings().exist("irRenderCamFOV"))
             {
-                if (camera_is_persp)
-                {
-                    m_params.insert_path("irRenderCamFOV", "54.0");
-                }
-                else
-                    m_params.insert_path("irRenderCamFOV", "90.0");
+                m_params.insert_path(
+                    "irRenderCamFOV",
+                    camera_is_persp ? get_camera_fov(*camera) : 90.0);
             }
 
             if (!m_params.strings().exist("irRenderCamRatio"))
             {
-                m_params.insert_path("irRenderCamRatio", "1.0");
+                const asf::CanvasProperties& props = frame->image().properties();
+                m_params.insert_path(
+                    "irRenderCamRatio",
+                    static_cast<double>(props.m_canvas_width) / props.m_canvas_height);
             }
 
             if (!m_params.strings().exist("irRenderCamXform"))
@@ -342,6 +1501,24 @@ namespace
             }
         }
 
+        // Horizontal field of view of a perspective camera, in degrees.
+        static double get_camera_fov(const asr::Camera& camera)
+        {
+            const asr::ParamArray& params = camera.get_parameters();
+
+            if (params.strings().exist("horizontal_fov"))
+                return params.get<double>("horizontal_fov");
+
+            if (params.strings().exist("film_dimensions") && params.strings().exist("focal_length"))
+            {
+                const asf::Vector2d film_dimensions = params.get<asf::Vector2d>("film_dimensions");
+                const double focal_length = params.get<double>("focal_length");
+                return asf::rad_to_deg(2.0 * std::atan(0.5 * film_dimensions[0] / focal_length));
+            }
+
+            return 54.0;
+        }
+
         void compute_transform_sequence(const asr::Assembly& assembly)
         {
             const asr::Assembly* parent_assembly =
@@ -390,6 +1567,10 @@ namespace
             return Model;
         }
 
+        // Expand the whole patch. appleseed expands procedural assemblies
+        // while it prepares the scene and has no hook to expand them on the
+        // first ray hit or to evict them under a memory cap, so patches are
+        // not split into lazily expanded regions.
         bool do_expand_contents(
             const asr::Project&     project,
             const asr::Assembly*    parent,
@@ -408,6 +1589,18 @@ namespace
             }
 
             XGenCallbacks xgen_callbacks(project, *this);
+
+            // Reuse the primitives of a previous expansion with the same inputs.
+            const std::string cache_file_path = get_cache_file_path(xgen_callbacks);
+            if (!cache_file_path.empty() && load_cache_file(cache_file_path, *this))
+            {
+                RENDERER_LOG_DEBUG(
+                    "XGen procedural assembly: loaded %s from cache file %s",
+                    get_name(),
+                    cache_file_path.c_str());
+                return true;
+            }
+
             std::unique_ptr<PatchRenderer> patch_renderer(
                 PatchRenderer::init(&xgen_callbacks, xgen_args.c_str()));
 
@@ -417,32 +1610,154 @@ namespace
                 return false;
             }
 
-            bbox bbox;
-            unsigned int face_id;
-            bool success = true;
+            // Collect the faces to render.
+            std::vector<unsigned int> face_ids;
+            {
+                bbox bbox;
+                unsigned int face_id;
+
+                while (patch_renderer->nextFace(bbox, face_id))
+                {
+                    if (!isEmpty(bbox))
+                        face_ids.push_back(face_id);
+                }
+            }
+
+            return
+                expand_faces(project, xgen_args, *patch_renderer, face_ids, abort_switch) &&
+                write_cache_file(cache_file_path);
+        }
 
-            while (patch_renderer->nextFace(bbox, face_id))
+      private:
+        // Return the path of the expansion cache file of this assembly,
+        // or an empty string if caching is disabled.
+        std::string get_cache_file_path(const XGenCallbacks& xgen_callbacks) const
+        {
+            const asr::ParamArray& params = get_parameters();
+
+            if (!params.strings().exist("cache_dir") || !params.strings().exist("cache_key"))
+                return std::string();
+
+            const std::string key =
+                asf::format(
+                    "{0};{1};{2}",
+                    params.get("cache_key"),
+                    get_name(),
+                    xgen_callbacks.get_cache_variant());
+
+            char file_name[32];
+            std::snprintf(
+                file_name,
+                sizeof(file_name),
+                "%016llx.asxgc",
+                static_cast<unsigned long long>(hash_string(key)));
+
+            return asf::format("{0}/{1}", params.get("cache_dir"), file_name);
+        }
+
+        // Failing to write the cache is not an error.
+        bool write_cache_file(const std::string& path) const
+        {
+            if (!path.empty() && !save_cache_file(path, *this))
             {
-                if (isEmpty(bbox))
-                    continue;
+                RENDERER_LOG_WARNING(
+                    "XGen procedural assembly: could not write cache file %s",
+                    path.c_str());
+            }
 
-                std::unique_ptr<FaceRenderer> face_renderer(FaceRenderer::init(
-                    patch_renderer.get(),
-                    face_id,
-                    &xgen_callbacks));
+            return true;
+        }
+
+        // Render the faces in parallel. Each worker has its own callbacks and
+        // its own patch renderer, as XGen render objects are not documented to
+        // be thread safe. The entities created by the workers are merged once
+        // all workers are done.
+        bool expand_faces(
+            const asr::Project&                 project,
+            const std::string&                  xgen_args,
+            PatchRenderer&                      patch_renderer,
+            const std::vector<unsigned int>&    face_ids,
+            asf::IAbortSwitch*                  abort_switch)
+        {
+            if (face_ids.empty())
+                return true;
+
+            const size_t worker_count = std::min(get_worker_count(), face_ids.size());
+
+            std::vector<std::unique_ptr<XGenCallbacks>> worker_callbacks;
+            for (size_t i = 0; i < worker_count; ++i)
+                worker_callbacks.emplace_back(new XGenCallbacks(project, *this, i));
+
+            // The first worker reuses the patch renderer that listed the faces.
+            // Patch renderers are created serially, before the workers start.
+            std::vector<std::unique_ptr<PatchRenderer>> worker_patch_renderers(worker_count);
+            for (size_t i = 1; i < worker_count; ++i)
+            {
+                worker_patch_renderers[i].reset(
+                    PatchRenderer::init(worker_callbacks[i].get(), xgen_args.c_str()));
 
-                if (face_renderer)
+                if (!worker_patch_renderers[i])
                 {
-                    success = success && face_renderer->render();
+                    RENDERER_LOG_ERROR("Error creating XGen patch renderer");
+                    return false;
                 }
-                else
+            }
+
+            std::atomic<size_t> next_face(0);
+            std::atomic<bool> success(true);
+
+            auto worker_func = [&](const size_t worker_index)
+            {
+                XGenCallbacks* callbacks = worker_callbacks[worker_index].get();
+                PatchRenderer* worker_patch_renderer = worker_index == 0
+                    ? &patch_renderer
+                    : worker_patch_renderers[worker_index].get();
+
+                while (success && !asf::is_aborted(abort_switch))
                 {
-                    RENDERER_LOG_ERROR("Error creating XGen face renderer");
-                    success = false;
+                    const size_t face_index = next_face++;
+                    if (face_index >= face_ids.size())
+                        break;
+
+                    std::unique_ptr<FaceRenderer> face_renderer(FaceRenderer::init(
+                        worker_patch_renderer,
+                        face_ids[face_index],
+                        callbacks));
+
+                    if (!face_renderer)
+                    {
+                        RENDERER_LOG_ERROR("Error creating XGen face renderer");
+                        success = false;
+                    }
+                    else if (!face_renderer->render())
+                        success = false;
                 }
-            }
+            };
+
+            std::vector<std::thread> workers;
+            for (size_t i = 1; i < worker_count; ++i)
+                workers.emplace_back(worker_func, i);
+
+            worker_func(0);
 
-            return success;
+            for (std::thread& worker : workers)
+                worker.join();
+
+            if (!success || asf::is_aborted(abort_switch))
+                return false;
+
+            for (size_t i = 0; i < worker_count; ++i)
+                worker_callbacks[i]->move_entities_to(*this);
+
+            return true;
+        }
+
+        size_t get_worker_count() const
+        {
+            // The thread_count parameter limits the number of expansion threads.
+            const size_t hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+            const size_t thread_count = get_parameters().get_optional<size_t>("thread_count", 0);
+            return thread_count > 0 ? thread_count : hardware_threads;
         }
     };
 
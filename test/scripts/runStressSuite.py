@@ -0,0 +1,274 @@
+#
+# This source file is part of appleseed.
+# Visit https://appleseedhq.net/ for additional information and resources.
+#
+# This software is released under the MIT license.
+#
+# Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+
+"""Run the appleseed-maya stress scenes and record how they scale.
+
+Each scenario of stressScenes.py is rendered in batch mode for a range of
+parameter values, each in its own mayapy process. The export time, the
+time to first pixel (both read from the export profiler trace), the total
+render time and the peak resident memory of the process are appended to a
+CSV file, together with the git commit, so that results can be tracked
+over commits and plotted as scaling curves.
+
+    mayapy runStressSuite.py --csv stress.csv [--quick] [--scenario materials]
+"""
+
+import argparse
+import csv
+import datetime
+import json
+import os
+import platform
+import subprocess
+import sys
+import tempfile
+import time
+
+ScriptDir = os.path.dirname(os.path.abspath(__file__))
+
+# Parameter values of each scenario, in increasing order.
+Suite = [
+    ("instances", [100, 1000, 10000]),
+    ("copies", [100, 1000, 5000]),
+    ("materials", [10, 100, 1000]),
+    ("depth", [10, 100, 1000]),
+    ("faceMaterials", [2, 16, 128]),
+    ("motionSamples", [2, 4, 8, 16])
+]
+
+CsvColumns = [
+    "date",
+    "commit",
+    "host",
+    "mayaVersion",
+    "scenario",
+    "value",
+    "status",
+    "exportSeconds",
+    "firstPixelSeconds",
+    "renderSeconds",
+    "totalSeconds",
+    "peakRssMB"
+]
+
+
+def _gitCommit():
+    try:
+        output = subprocess.check_output(
+            ["git", "rev-parse", "--short", "HEAD"],
+            cwd=ScriptDir,
+            stderr=subprocess.STDOUT)
+        return output.decode("utf-8").strip()
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def _peakRssMB():
+    try:
+        import resource
+    except ImportError:
+        # Windows.
+        try:
+            import psutil
+            return psutil.Process().memory_info().peak_wset / (1024.0 * 1024.0)
+        except (ImportError, AttributeError):
+            return None
+
+    rss = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+
+    # Bytes on macOS, kilobytes elsewhere.
+    if sys.platform == "darwin":
+        return rss / (1024.0 * 1024.0)
+    return rss / 1024.0
+
+
+def _phaseSeconds(trace, phase):
+    """Total duration of the top level events of a phase, in seconds."""
+
+    total = 0
+    for event in trace.get("traceEvents", []):
+        if event.get("ph") == "X" and event.get("cat") == "phase" and event.get("name") == phase:
+            total += event.get("dur", 0)
+
+    return total * 1.0e-6 if total else None
+
+
+def runWorker(scenario, value, workDir, resultFilename):
+    """Build and render one scene. Runs in a separate mayapy process."""
+
+    import maya.standalone
+    maya.standalone.initialize(name="python")
+
+    import maya.cmds as mc
+
+    sys.path.insert(0, ScriptDir)
+    import stressScenes
+
+    result = {"status": "failed"}
+
+    try:
+        stressScenes.buildScene(scenario, value)
+
+        name = "%s_%d" % (scenario, value)
+        mc.file(rename=os.path.join(workDir, name + ".ma"))
+
+        traceFilename = os.path.join(workDir, name + ".trace.json")
+        mc.setAttr("appleseedRenderGlobals.profileExport", True)
+        mc.setAttr("appleseedRenderGlobals.profileFilename", traceFilename, type="string")
+        mc.setAttr("defaultRenderGlobals.imageFilePrefix", os.path.join(workDir, name), type="string")
+
+        start = time.time()
+        mc.appleseedRender(batch="")
+        result["totalSeconds"] = time.time() - start
+
+        with open(traceFilename) as f:
+            trace = json.load(f)
+
+        result["exportSeconds"] = _phaseSeconds(trace, "exportProject")
+        result["firstPixelSeconds"] = _phaseSeconds(trace, "firstPixel")
+        result["renderSeconds"] = _phaseSeconds(trace, "render")
+        result["mayaVersion"] = mc.about(version=True)
+        result["status"] = "ok"
+    except Exception as e:
+        result["error"] = str(e)
+    finally:
+        result["peakRssMB"] = _peakRssMB()
+
+        with open(resultFilename, "w") as f:
+            json.dump(result, f)
+
+        maya.standalone.uninitialize()
+
+
+def runScene(mayapy, scenario, value, workDir, timeout):
+    resultFilename = os.path.join(workDir, "%s_%d.result.json" % (scenario, value))
+
+    command = [
+        mayapy,
+        os.path.abspath(__file__),
+        "--worker",
+        "--scenario", scenario,
+        "--value", str(value),
+        "--work-dir", workDir,
+        "--result", resultFilename
+    ]
+
+    process = subprocess.Popen(command)
+    deadline = time.time() + timeout
+    while process.poll() is None:
+        if time.time() > deadline:
+            process.kill()
+            process.wait()
+            return {"status": "timeout"}
+        time.sleep(0.5)
+
+    if not os.path.exists(resultFilename):
+        return {"status": "crashed"}
+
+    with open(resultFilename) as f:
+        return json.load(f)
+
+
+def _openCsv(filename):
+    # The csv module wants binary files in Python 2, and no newline translation in Python 3.
+    if sys.version_info[0] < 3:
+        return open(filename, "ab")
+    return open(filename, "a", newline="")
+
+
+def _formatValue(value):
+    if value is None:
+        return ""
+    if isinstance(value, float):
+        return "%.4f" % value
+    return value
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the appleseed-maya stress scene suite.")
+    parser.add_argument("--csv", default="stress.csv", help="CSV file the results are appended to")
+    parser.add_argument("--mayapy", default=sys.executable, help="mayapy executable used to render the scenes")
+    parser.add_argument("--scenario", action="append", help="only run these scenarios")
+    parser.add_argument("--quick", action="store_true", help="only run the two smallest values of each scenario")
+    parser.add_argument("--work-dir", help="directory for the scenes, traces and images (default: temporary)")
+    parser.add_argument("--timeout", type=float, default=3600.0, help="timeout per scene, in seconds")
+
+    # Internal, used to render a single scene in a child process.
+    parser.add_argument("--worker", action="store_true", help=argparse.SUPPRESS)
+    parser.add_argument("--value", type=int, help=argparse.SUPPRESS)
+    parser.add_argument("--result", help=argparse.SUPPRESS)
+
+    args = parser.parse_args()
+
+    if args.worker:
+        runWorker(args.scenario[0], args.value, args.work_dir, args.result)
+        return 0
+
+    workDir = args.work_dir or tempfile.mkdtemp(prefix="appleseedmaya_stress_")
+    if not os.path.isdir(workDir):
+        os.makedirs(workDir)
+
+    writeHeader = not os.path.exists(args.csv) or os.path.getsize(args.csv) == 0
+    commit = _gitCommit()
+    date = datetime.datetime.now().strftime("%Y-%m-%d %H:%M:%S")
+    failures = 0
+
+    with _openCsv(args.csv) as f:
+        writer = csv.writer(f)
+        if writeHeader:
+            writer.writerow(CsvColumns)
+
+        for scenario, values in Suite:
+            if args.scenario and scenario not in args.scenario:
+                continue
+
+            for value in values[:2] if args.quick else values:
+                print("Running %s = %d" % (scenario, value))
+                result = runScene(args.mayapy, scenario, value, workDir, args.timeout)
+
+                if result["status"] != "ok":
+                    failures += 1
+                    print("  %s %s" % (result["status"], result.get("error", "")))
+
+                row = dict(result)
+                row.update({
+                    "date": date,
+                    "commit": commit,
+                    "host": platform.node(),
+                    "scenario": scenario,
+                    "value": value
+                })
+                writer.writerow([_formatValue(row.get(column)) for column in CsvColumns])
+                f.flush()
+
+    print("Results appended to %s, scenes and traces in %s" % (args.csv, workDir))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,238 @@
+#
+# This source file is part of appleseed.
+# Visit https://appleseedhq.net/ for additional information and resources.
+#
+# This software is released under the MIT license.
+#
+# Copyright (c) 2016-2019 Esteban Tovagliari, The appleseedhq Organization
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+
+"""Synthetic stress scenes for appleseed-maya.
+
+Builds parameterised scenes that stress one part of the exporter at a time:
+
+    instances       N Maya instances of a single mesh (DAG instancing)
+    copies          N identical mesh copies (detected as instances by hashing)
+    materials       M meshes, each with its own material
+    depth           a DAG hierarchy D levels deep, with a mesh at each level
+    faceMaterials   a 256k faces mesh with M per-face material assignments
+    motionSamples   64 deforming rigs, rendered with K motion samples
+
+Run inside mayapy, or in a Maya session:
+
+    mayapy stressScenes.py --scenario materials --value 100 --output materials_100.ma
+"""
+
+import argparse
+import math
+
+import maya.cmds as mc
+
+
+# Image size and sampling used by all stress scenes. They are kept small,
+# as the scenes measure export and time to first pixel, not rendering.
+ImageWidth = 320
+ImageHeight = 240
+
+
+def _gridPosition(index, count, spacing=2.5):
+    side = int(math.ceil(math.sqrt(count)))
+    return ((index % side - side * 0.5) * spacing, 0.0, (index // side - side * 0.5) * spacing)
+
+
+def _createMaterial(name, color):
+    shader = mc.shadingNode("lambert", asShader=True, name=name)
+    mc.setAttr(shader + ".color", color[0], color[1], color[2], type="double3")
+    shadingGroup = mc.sets(renderable=True, noSurfaceShader=True, empty=True, name=name + "SG")
+    mc.connectAttr(shader + ".outColor", shadingGroup + ".surfaceShader")
+    return shadingGroup
+
+
+def _color(index, count):
+    h = 2.0 * math.pi * float(index) / max(count, 1)
+    return tuple(0.5 + 0.5 * math.sin(h + offset) for offset in (0.0, 2.1, 4.2))
+
+
+def _createRenderGlobals():
+    if not mc.objExists("appleseedRenderGlobals"):
+        mc.createNode("appleseedRenderGlobals", name="appleseedRenderGlobals", shared=True, skipSelect=True)
+
+    mc.setAttr("defaultRenderGlobals.currentRenderer", "appleseed", type="string")
+    mc.setAttr("defaultResolution.width", ImageWidth)
+    mc.setAttr("defaultResolution.height", ImageHeight)
+
+    mc.setAttr("appleseedRenderGlobals.passes", 1)
+    mc.setAttr("appleseedRenderGlobals.samples", 1)
+    mc.setAttr("appleseedRenderGlobals.bounces", 1)
+
+
+def _createCameraAndLight(sceneSize):
+    # Frame the whole scene.
+    camera, cameraShape = mc.camera(name="stressCamera")
+    distance = max(sceneSize, 1.0) * 1.5
+    mc.xform(camera, translation=(0.0, distance, distance), rotation=(-45.0, 0.0, 0.0))
+
+    for c in mc.ls(type="camera"):
+        mc.setAttr(c + ".renderable", c == cameraShape)
+
+    mc.directionalLight(rotation=(-45.0, 30.0, 0.0))
+
+
+def buildInstances(count):
+    source = mc.polySphere(name="instanceSource", subdivisionsX=64, subdivisionsY=64)[0]
+    mc.sets(source, forceElement=_createMaterial("instanceMaterial", (0.8, 0.8, 0.8)))
+
+    for i in range(1, count):
+        instance = mc.instance(source)[0]
+        mc.xform(instance, translation=_gridPosition(i, count))
+
+    return math.sqrt(count) * 2.5
+
+
+def buildCopies(count):
+    source = mc.polySphere(name="copySource", subdivisionsX=64, subdivisionsY=64)[0]
+    mc.sets(source, forceElement=_createMaterial("copyMaterial", (0.8, 0.8, 0.8)))
+
+    for i in range(1, count):
+        copy = mc.duplicate(source)[0]
+        mc.xform(copy, translation=_gridPosition(i, count))
+
+    return math.sqrt(count) * 2.5
+
+
+def buildMaterials(count):
+    for i in range(count):
+        mesh = mc.polyCube(name="materialCube%d" % i)[0]
+        mc.xform(mesh, translation=_gridPosition(i, count))
+        mc.sets(mesh, forceElement=_createMaterial("material%d" % i, _color(i, count)))
+
+    return math.sqrt(count) * 2.5
+
+
+def buildHierarchy(depth):
+    shadingGroup = _createMaterial("hierarchyMaterial", (0.8, 0.8, 0.8))
+
+    parent = None
+    for i in range(depth):
+        group = mc.group(empty=True, name="level%d" % i)
+        if parent:
+            group = mc.parent(group, parent, relative=True)[0]
+
+        mc.xform(group, translation=(0.1, 0.0, 0.0), rotation=(0.0, 2.0, 0.0), scale=(0.999, 0.999, 0.999))
+
+        mesh = mc.polyCube(name="levelCube%d" % i)[0]
+        mesh = mc.parent(mesh, group, relative=True)[0]
+        mc.sets(mesh, forceElement=shadingGroup)
+
+        parent = group
+
+    return depth * 0.1 + 2.0
+
+
+def buildFaceMaterials(count):
+    subdivisions = 512
+    mesh = mc.polyPlane(
+        name="faceMaterialPlane",
+        width=20,
+        height=20,
+        subdivisionsX=subdivisions,
+        subdivisionsY=subdivisions)[0]
+
+    # Assign materials to contiguous ranges of faces.
+    faceCount = subdivisions * subdivisions
+    for i in range(count):
+        first = faceCount * i // count
+        last = faceCount * (i + 1) // count - 1
+        shadingGroup = _createMaterial("faceMaterial%d" % i, _color(i, count))
+        mc.sets("%s.f[%d:%d]" % (mesh, first, last), forceElement=shadingGroup)
+
+    return 15.0
+
+
+def buildMotionSamples(samples, rigCount=64):
+    shadingGroup = _createMaterial("rigMaterial", (0.8, 0.8, 0.8))
+
+    for i in range(rigCount):
+        mesh = mc.polyCylinder(name="rig%d" % i, height=4, subdivisionsX=32, subdivisionsY=32)[0]
+        mc.xform(mesh, translation=_gridPosition(i, rigCount, spacing=4.0))
+        mc.sets(mesh, forceElement=shadingGroup)
+
+        # A keyed bend deformer and a keyed transform.
+        bend, handle = mc.nonLinear(mesh, type="bend")
+        mc.setKeyframe(bend, attribute="curvature", time=0, value=-1.0)
+        mc.setKeyframe(bend, attribute="curvature", time=2, value=1.0)
+        mc.setKeyframe(mesh, attribute="rotateY", time=0, value=0.0)
+        mc.setKeyframe(mesh, attribute="rotateY", time=2, value=30.0)
+
+    mc.currentTime(1)
+
+    mc.setAttr("appleseedRenderGlobals.motionBlur", True)
+    mc.setAttr("appleseedRenderGlobals.mbTransformSamples", samples)
+    mc.setAttr("appleseedRenderGlobals.mbDeformSamples", samples)
+
+    return math.sqrt(rigCount) * 4.0
+
+
+Scenarios = {
+    "instances": buildInstances,
+    "copies": buildCopies,
+    "materials": buildMaterials,
+    "depth": buildHierarchy,
+    "faceMaterials": buildFaceMaterials,
+    "motionSamples": buildMotionSamples
+}
+
+
+def buildScene(scenario, value):
+    """Create a new scene for a scenario and parameter value."""
+
+    if scenario not in Scenarios:
+        raise ValueError("Unknown stress scenario %s" % scenario)
+
+    mc.file(new=True, force=True)
+    mc.loadPlugin("appleseedMaya", quiet=True)
+    _createRenderGlobals()
+
+    sceneSize = Scenarios[scenario](value)
+    _createCameraAndLight(sceneSize)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate an appleseed-maya stress scene.")
+    parser.add_argument("--scenario", required=True, choices=sorted(Scenarios.keys()))
+    parser.add_argument("--value", required=True, type=int)
+    parser.add_argument("--output", required=True, help="Maya ASCII file to write")
+    args = parser.parse_args()
+
+    import maya.standalone
+    maya.standalone.initialize(name="python")
+
+    try:
+        buildScene(args.scenario, args.value)
+        mc.file(rename=args.output)
+        mc.file(save=True, type="mayaAscii", force=True)
+    finally:
+        maya.standalone.uninitialize()
+
+
+if __name__ == "__main__":
+    main()